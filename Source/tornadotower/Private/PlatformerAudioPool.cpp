@@ -0,0 +1,123 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "tornadotower.h"
+#include "../Public/PlatformerAudioPool.h"
+
+APlatformerAudioPool::APlatformerAudioPool (const FObjectInitializer& ObjectInitializer)
+	: Super (ObjectInitializer) {
+	MaxVoices = 16;
+}
+
+APlatformerAudioPool* APlatformerAudioPool::Get (UWorld* World) {
+	if (!World || !World->IsGameWorld () || World->GetNetMode () == NM_DedicatedServer || !World->GetAudioDevice ()) {
+		return nullptr;
+	}
+
+	for (TActorIterator<APlatformerAudioPool> It (World); It; ++It) {
+		return *It;
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	return World->SpawnActor<APlatformerAudioPool> (SpawnParams);
+}
+
+void APlatformerAudioPool::PostInitializeComponents () {
+	Super::PostInitializeComponents ();
+
+	Voices.SetNum (FMath::Max (MaxVoices, 1));
+	for (FPlatformerPooledVoice& Voice : Voices) {
+		Voice.Component = NewObject<UAudioComponent> (this);
+		Voice.Component->bAutoActivate = false;
+		Voice.Component->bAutoDestroy = false;
+		Voice.Component->RegisterComponent ();
+	}
+}
+
+FPlatformerSoundHandle APlatformerAudioPool::Play (USoundBase* Sound, USceneComponent* AttachTo, FName SocketName) {
+	FPlatformerSoundHandle Handle;
+	if (!Sound || !AttachTo) {
+		return Handle;
+	}
+
+	const int32 VoiceIdx = FindVoice (AttachTo->GetSocketLocation (SocketName));
+	if (VoiceIdx == INDEX_NONE) {
+		return Handle;
+	}
+
+	FPlatformerPooledVoice& Voice = Voices[VoiceIdx];
+	if (Voice.bActive) {
+		ReleaseVoice (Voice);
+	}
+
+	Voice.bActive = true;
+	Voice.Serial++;
+	Voice.Component->AttachToComponent (AttachTo, FAttachmentTransformRules::SnapToTargetNotIncludingScale, SocketName);
+	Voice.Component->SetSound (Sound);
+	Voice.Component->Play ();
+
+	Handle.Voice = VoiceIdx;
+	Handle.Serial = Voice.Serial;
+	return Handle;
+}
+
+void APlatformerAudioPool::Stop (FPlatformerSoundHandle& Handle) {
+	if (Voices.IsValidIndex (Handle.Voice)) {
+		FPlatformerPooledVoice& Voice = Voices[Handle.Voice];
+		if (Voice.bActive && Voice.Serial == Handle.Serial) {
+			ReleaseVoice (Voice);
+		}
+	}
+
+	Handle.Invalidate ();
+}
+
+bool APlatformerAudioPool::IsPlaying (const FPlatformerSoundHandle& Handle) const {
+	if (!Voices.IsValidIndex (Handle.Voice)) {
+		return false;
+	}
+
+	const FPlatformerPooledVoice& Voice = Voices[Handle.Voice];
+	return Voice.bActive && Voice.Serial == Handle.Serial && Voice.Component->IsPlaying ();
+}
+
+int32 APlatformerAudioPool::FindVoice (const FVector& Location) const {
+	const FVector ListenerLocation = GetListenerLocation ();
+
+	int32 FarthestIdx = INDEX_NONE;
+	float FarthestDistSq = FVector::DistSquared (Location, ListenerLocation);
+	for (int32 Idx = 0; Idx < Voices.Num (); Idx++) {
+		const FPlatformerPooledVoice& Voice = Voices[Idx];
+
+		// free, or finished on its own
+		if (!Voice.bActive || !Voice.Component->IsPlaying ()) {
+			return Idx;
+		}
+
+		const float DistSq = FVector::DistSquared (Voice.Component->GetComponentLocation (), ListenerLocation);
+		if (DistSq > FarthestDistSq) {
+			FarthestDistSq = DistSq;
+			FarthestIdx = Idx;
+		}
+	}
+
+	return FarthestIdx;
+}
+
+FVector APlatformerAudioPool::GetListenerLocation () const {
+	APlayerController* PlayerController = GetWorld ()->GetFirstPlayerController ();
+	if (PlayerController) {
+		FVector ViewLocation;
+		FRotator ViewRotation;
+		PlayerController->GetPlayerViewPoint (ViewLocation, ViewRotation);
+		return ViewLocation;
+	}
+
+	return FVector::ZeroVector;
+}
+
+void APlatformerAudioPool::ReleaseVoice (FPlatformerPooledVoice& Voice) {
+	Voice.bActive = false;
+	Voice.Component->Stop ();
+	Voice.Component->DetachFromComponent (FDetachmentTransformRules::KeepWorldTransform);
+}
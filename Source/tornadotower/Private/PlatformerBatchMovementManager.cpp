@@ -0,0 +1,73 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "tornadotower.h"
+#include "../Public/PlatformerBatchMovementManager.h"
+#include "../Public/PlatformerPlayerMovementComp.h"
+#include "../Public/PlatformerPerfCounters.h"
+#include "ParallelFor.h"
+
+APlatformerBatchMovementManager::APlatformerBatchMovementManager (const FObjectInitializer& ObjectInitializer)
+	: Super (ObjectInitializer) {
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.TickGroup = TG_PrePhysics;
+
+	bEnableBatchMovement = true;
+	MinParallelMoves = 16;
+}
+
+APlatformerBatchMovementManager* APlatformerBatchMovementManager::Get (UWorld* World) {
+	if (!World || !World->IsGameWorld () || World->GetNetMode () == NM_Client) {
+		return nullptr;
+	}
+
+	for (TActorIterator<APlatformerBatchMovementManager> It (World); It; ++It) {
+		return *It;
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	return World->SpawnActor<APlatformerBatchMovementManager> (SpawnParams);
+}
+
+void APlatformerBatchMovementManager::RegisterMovement (UPlatformerPlayerMovementComp* Movement) {
+	if (Movements.AddUnique (Movement) != INDEX_NONE) {
+		Movement->PrimaryComponentTick.AddPrerequisite (this, PrimaryActorTick);
+	}
+}
+
+void APlatformerBatchMovementManager::UnregisterMovement (UPlatformerPlayerMovementComp* Movement) {
+	Movements.RemoveSingleSwap (Movement);
+	Movement->PrimaryComponentTick.RemovePrerequisite (this, PrimaryActorTick);
+}
+
+void APlatformerBatchMovementManager::Tick (float DeltaSeconds) {
+	Super::Tick (DeltaSeconds);
+
+	PLATFORMER_SCOPE_CYCLE_COUNTER (BatchMovement);
+
+	Moves.Reset ();
+	if (!bEnableBatchMovement || DeltaSeconds <= 0.0f) {
+		return;
+	}
+
+	for (int32 Idx = Movements.Num () - 1; Idx >= 0; Idx--) {
+		UPlatformerPlayerMovementComp* Movement = Movements[Idx].Get ();
+		if (!Movement) {
+			Movements.RemoveAtSwap (Idx);
+			continue;
+		}
+
+		if (Movement->CanUseBatchMovement ()) {
+			Movement->PrepareBatchMove (DeltaSeconds, Moves[Moves.AddDefaulted ()]);
+		}
+	}
+
+	// every task writes only its own pawn's velocity and slide state, world is only queried
+	ParallelFor (Moves.Num (), [this] (int32 Idx) {
+		Moves[Idx].Movement->SimulateBatchMove (Moves[Idx]);
+	}, Moves.Num () < MinParallelMoves);
+
+	for (const FPlatformerBatchMove& Move : Moves) {
+		Move.Movement->ApplyBatchMove (Move);
+	}
+}
@@ -0,0 +1,406 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "tornadotower.h"
+#include "../Public/PlatformerBenchmarkCommandlet.h"
+#include "../Public/PlatformerCharacter.h"
+#include "../Public/PlatformerPlayerMovementComp.h"
+#include "../Public/PlatformerTestLevel.h"
+#include "Json.h"
+
+DEFINE_LOG_CATEGORY_STATIC (LogPlatformerBenchmark, Log, All);
+
+namespace PlatformerBenchmark {
+
+/** forwards to wrapped allocator, counting allocations made on game thread while enabled */
+class FCountingMalloc : public FMalloc {
+public:
+	FCountingMalloc (FMalloc* InInner)
+		: Inner (InInner)
+		, NumAllocs (0)
+		, bCounting (false) {
+	}
+
+	virtual void* Malloc (SIZE_T Size, uint32 Alignment) override {
+		Count ();
+		return Inner->Malloc (Size, Alignment);
+	}
+
+	virtual void* Realloc (void* Original, SIZE_T Size, uint32 Alignment) override {
+		if (Size > 0) {
+			Count ();
+		}
+		return Inner->Realloc (Original, Size, Alignment);
+	}
+
+	virtual void Free (void* Original) override {
+		Inner->Free (Original);
+	}
+
+	virtual bool GetAllocationSize (void* Original, SIZE_T& SizeOut) override {
+		return Inner->GetAllocationSize (Original, SizeOut);
+	}
+
+	virtual void Trim () override {
+		Inner->Trim ();
+	}
+
+	virtual bool IsInternallyThreadSafe () const override {
+		return Inner->IsInternallyThreadSafe ();
+	}
+
+	virtual bool ValidateHeap () override {
+		return Inner->ValidateHeap ();
+	}
+
+	virtual const TCHAR* GetDescriptiveName () override {
+		return TEXT ("PlatformerBenchmarkCounting");
+	}
+
+	void Start () {
+		NumAllocs = 0;
+		bCounting = true;
+	}
+
+	int64 Stop () {
+		bCounting = false;
+		return NumAllocs;
+	}
+
+private:
+	void Count () {
+		if (bCounting && IsInGameThread ()) {
+			NumAllocs++;
+		}
+	}
+
+	FMalloc* Inner;
+	int64 NumAllocs;
+	bool bCounting;
+};
+
+/** single timed function ; Prepare restores state before each call and is subtracted from results */
+struct FCase {
+	FString Name;
+	TFunction<void ()> Prepare;
+	TFunction<void ()> Run;
+};
+
+struct FResult {
+	FString Name;
+	double NsPerCall;
+	double AllocsPerCall;
+};
+
+static FResult RunCase (const FCase& Case, int32 Iterations, FCountingMalloc& Counter) {
+	// warm up caches and lazily allocated containers
+	for (int32 Idx = 0; Idx < FMath::Min (Iterations, 100); Idx++) {
+		Case.Prepare ();
+		Case.Run ();
+	}
+
+	Counter.Start ();
+	double StartTime = FPlatformTime::Seconds ();
+	for (int32 Idx = 0; Idx < Iterations; Idx++) {
+		Case.Prepare ();
+	}
+	const double PrepareTime = FPlatformTime::Seconds () - StartTime;
+	const int64 PrepareAllocs = Counter.Stop ();
+
+	Counter.Start ();
+	StartTime = FPlatformTime::Seconds ();
+	for (int32 Idx = 0; Idx < Iterations; Idx++) {
+		Case.Prepare ();
+		Case.Run ();
+	}
+	const double TotalTime = FPlatformTime::Seconds () - StartTime;
+	const int64 TotalAllocs = Counter.Stop ();
+
+	FResult Result;
+	Result.Name = Case.Name;
+	Result.NsPerCall = FMath::Max (TotalTime - PrepareTime, 0.0) * 1.0e9 / Iterations;
+	Result.AllocsPerCall = (double)FMath::Max<int64> (TotalAllocs - PrepareAllocs, 0) / Iterations;
+	return Result;
+}
+
+static bool WriteResults (const FString& Filename, const TArray<FResult>& Results, int32 Iterations) {
+	TSharedRef<FJsonObject> Root = MakeShareable (new FJsonObject ());
+	Root->SetNumberField (TEXT ("Iterations"), Iterations);
+
+	TArray<TSharedPtr<FJsonValue>> Cases;
+	for (const FResult& Result : Results) {
+		TSharedRef<FJsonObject> Case = MakeShareable (new FJsonObject ());
+		Case->SetStringField (TEXT ("Name"), Result.Name);
+		Case->SetNumberField (TEXT ("NsPerCall"), Result.NsPerCall);
+		Case->SetNumberField (TEXT ("AllocsPerCall"), Result.AllocsPerCall);
+		Cases.Add (MakeShareable (new FJsonValueObject (Case)));
+	}
+	Root->SetArrayField (TEXT ("Results"), Cases);
+
+	FString Output;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create (&Output);
+	FJsonSerializer::Serialize (Root, Writer);
+	return FFileHelper::SaveStringToFile (Output, *Filename);
+}
+
+static bool ReadResults (const FString& Filename, TMap<FString, FResult>& OutResults) {
+	FString Input;
+	if (!FFileHelper::LoadFileToString (Input, *Filename)) {
+		return false;
+	}
+
+	TSharedPtr<FJsonObject> Root;
+	TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create (Input);
+	if (!FJsonSerializer::Deserialize (Reader, Root) || !Root.IsValid ()) {
+		return false;
+	}
+
+	for (const TSharedPtr<FJsonValue>& Value : Root->GetArrayField (TEXT ("Results"))) {
+		const TSharedPtr<FJsonObject>& Case = Value->AsObject ();
+		FResult Result;
+		Result.Name = Case->GetStringField (TEXT ("Name"));
+		Result.NsPerCall = Case->GetNumberField (TEXT ("NsPerCall"));
+		Result.AllocsPerCall = Case->GetNumberField (TEXT ("AllocsPerCall"));
+		OutResults.Add (Result.Name, Result);
+	}
+
+	return true;
+}
+
+/** slide state at the end of a slide run */
+struct FSlideResult {
+	float Reduction;
+	float Speed;
+	bool bSliding;
+};
+
+/** returns number of regressions */
+static int32 CompareResults (const TArray<FResult>& Results, const TMap<FString, FResult>& Baseline, float Tolerance) {
+	int32 NumRegressions = 0;
+	for (const FResult& Result : Results) {
+		const FResult* Base = Baseline.Find (Result.Name);
+		if (!Base) {
+			UE_LOG (LogPlatformerBenchmark, Display, TEXT ("%s: no baseline"), *Result.Name);
+			continue;
+		}
+
+		const bool bSlower = Result.NsPerCall > Base->NsPerCall * (1.0f + Tolerance);
+		const bool bMoreAllocs = Result.AllocsPerCall > Base->AllocsPerCall + 0.01;
+		if (bSlower || bMoreAllocs) {
+			UE_LOG (LogPlatformerBenchmark, Error, TEXT ("%s: REGRESSION %.1f ns (baseline %.1f), %.2f allocs (baseline %.2f)"),
+				*Result.Name, Result.NsPerCall, Base->NsPerCall, Result.AllocsPerCall, Base->AllocsPerCall);
+			NumRegressions++;
+		} else {
+			UE_LOG (LogPlatformerBenchmark, Display, TEXT ("%s: ok %.1f ns (baseline %.1f)"), *Result.Name, Result.NsPerCall, Base->NsPerCall);
+		}
+	}
+
+	return NumRegressions;
+}
+
+}
+
+UPlatformerBenchmarkCommandlet::UPlatformerBenchmarkCommandlet (const FObjectInitializer& ObjectInitializer)
+	: Super (ObjectInitializer) {
+	IsClient = false;
+	IsEditor = false;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+bool UPlatformerBenchmarkCommandlet::CheckSlideLOD (APlatformerCharacter* Character, UPlatformerPlayerMovementComp* MoveComp, const FVector& Location, float Tolerance) {
+	using namespace PlatformerBenchmark;
+
+	const float Duration = 0.5f;
+	const float StartSpeed = 800.0f;
+
+	// slides pawn from Location for Duration with constant forward input, moving it by steps of StepTime in given movement LOD
+	auto RunSlide = [=] (EPlatformerMovementLOD LOD, float StepTime) -> FSlideResult {
+		Character->SetActorLocation (Location);
+		MoveComp->SetMovementMode (MOVE_Walking);
+		MoveComp->SetMovementLOD (LOD);
+		MoveComp->Velocity = FVector (StartSpeed, 0.0f, 0.0f);
+		MoveComp->StartSlide ();
+
+		const int32 NumSteps = FMath::RoundToInt (Duration / StepTime);
+		for (int32 Step = 0; Step < NumSteps && MoveComp->MovementMode == MOVE_Walking; Step++) {
+			MoveComp->Acceleration = FVector (MoveComp->GetMaxAcceleration (), 0.0f, 0.0f);
+			MoveComp->PhysWalking (StepTime, 0);
+		}
+
+		FSlideResult Result;
+		Result.Reduction = MoveComp->CurrentSlideVelocityReduction;
+		Result.Speed = MoveComp->Velocity.Size2D ();
+		Result.bSliding = MoveComp->IsSliding ();
+
+		MoveComp->TryToEndSlide ();
+		MoveComp->SetMovementLOD (EPlatformerMovementLOD::Full);
+		return Result;
+	};
+
+	const FSlideResult Full = RunSlide (EPlatformerMovementLOD::Full, 1.0f / 60.0f);
+	const FSlideResult Reduced = RunSlide (EPlatformerMovementLOD::Reduced, MoveComp->ReducedLODTickInterval);
+
+	const float ReductionError = FMath::Abs (Reduced.Reduction - Full.Reduction) / FMath::Max (FMath::Abs (Full.Reduction), 1.0f);
+	const float SpeedError = FMath::Abs (Reduced.Speed - Full.Speed) / FMath::Max (Full.Speed, 1.0f);
+	const bool bMatch = ReductionError <= Tolerance && SpeedError <= Tolerance && Reduced.bSliding == Full.bSliding;
+
+	UE_LOG (LogPlatformerBenchmark, Display, TEXT ("Slide LOD: full rate reduction %.2f speed %.1f, reduced LOD reduction %.2f speed %.1f (error %.1f%%, %.1f%%)"),
+		Full.Reduction, Full.Speed, Reduced.Reduction, Reduced.Speed, ReductionError * 100.0f, SpeedError * 100.0f);
+	if (!bMatch) {
+		UE_LOG (LogPlatformerBenchmark, Error, TEXT ("Slide LOD: reduced LOD slide differs from full rate by more than %.1f%%"), Tolerance * 100.0f);
+	}
+
+	return bMatch;
+}
+
+int32 UPlatformerBenchmarkCommandlet::Main (const FString& Params) {
+	using namespace PlatformerBenchmark;
+
+	int32 Iterations = 10000;
+	FParse::Value (*Params, TEXT ("Iterations="), Iterations);
+	Iterations = FMath::Max (Iterations, 1);
+
+	FString OutputFile = FPaths::GameSavedDir () / TEXT ("Benchmarks") / TEXT ("PlatformerBenchmark.json");
+	FParse::Value (*Params, TEXT ("Output="), OutputFile);
+
+	FString BaselineFile;
+	FParse::Value (*Params, TEXT ("Baseline="), BaselineFile);
+
+	float Tolerance = 0.1f;
+	FParse::Value (*Params, TEXT ("Tolerance="), Tolerance);
+
+	float SlideLODTolerance = 0.05f;
+	FParse::Value (*Params, TEXT ("SlideLODTolerance="), SlideLODTolerance);
+
+	FPlatformerTestLevel Level;
+	if (!Level.Create ()) {
+		UE_LOG (LogPlatformerBenchmark, Error, TEXT ("Failed to create test level"));
+		return 1;
+	}
+
+	APlatformerCharacter* Character = Level.SpawnCharacter (APlatformerCharacter::StaticClass (), 0.0f, 0.0f);
+	if (!Character) {
+		UE_LOG (LogPlatformerBenchmark, Error, TEXT ("Failed to spawn character"));
+		return 1;
+	}
+
+	// let pawn settle on the floor
+	for (int32 Idx = 0; Idx < 10; Idx++) {
+		Level.Tick (1.0f / 60.0f);
+	}
+
+	UPlatformerPlayerMovementComp* MoveComp = CastChecked<UPlatformerPlayerMovementComp> (Character->GetCharacterMovement ());
+	UCapsuleComponent* Capsule = Character->GetCapsuleComponent ();
+	const float DefRadius = Capsule->GetUnscaledCapsuleRadius ();
+	const float DefHalfHeight = Capsule->GetUnscaledCapsuleHalfHeight ();
+	const float SlideHalfHeight = MoveComp->SlideHeight;
+
+	const FVector OpenLocation (0.0f, 0.0f, DefHalfHeight + 1.0f);
+	const FVector OpenSlideLocation (0.0f, 0.0f, SlideHalfHeight + 1.0f);
+	const FVector CeilingSlideLocation ((FPlatformerTestLevel::CeilingStartX + FPlatformerTestLevel::CeilingEndX) * 0.5f, 0.0f, SlideHalfHeight + 1.0f);
+	const FVector ObstacleLocation (FPlatformerTestLevel::ObstacleX - DefRadius - 1.0f, 0.0f, DefHalfHeight + 1.0f);
+	const float DeltaTime = 1.0f / 60.0f;
+
+	TArray<FCase> Cases;
+
+	FCase PhysWalkingSlide;
+	PhysWalkingSlide.Name = TEXT ("PhysWalking.Slide");
+	PhysWalkingSlide.Prepare = [=] () {
+		Character->SetActorLocation (OpenSlideLocation);
+		MoveComp->SetMovementMode (MOVE_Walking);
+		MoveComp->Velocity = FVector (800.0f, 0.0f, 0.0f);
+		MoveComp->CurrentSlideVelocityReduction = 0.0f;
+		MoveComp->bInSlide = true;
+	};
+	PhysWalkingSlide.Run = [=] () {
+		MoveComp->PhysWalking (DeltaTime, 0);
+	};
+
+	FCase SetSlideHeight;
+	SetSlideHeight.Name = TEXT ("SetSlideCollisionHeight");
+	SetSlideHeight.Prepare = [=] () {
+		Capsule->SetCapsuleSize (DefRadius, DefHalfHeight);
+		Character->SetActorLocation (OpenLocation);
+	};
+	SetSlideHeight.Run = [=] () {
+		MoveComp->SetSlideCollisionHeight ();
+	};
+
+	FCase RestoreHeightClear;
+	RestoreHeightClear.Name = TEXT ("RestoreCollisionHeightAfterSlide.Clear");
+	RestoreHeightClear.Prepare = [=] () {
+		Capsule->SetCapsuleSize (DefRadius, SlideHalfHeight);
+		Character->SetActorLocation (OpenSlideLocation);
+	};
+	RestoreHeightClear.Run = [=] () {
+		MoveComp->RestoreCollisionHeightAfterSlide ();
+	};
+
+	FCase RestoreHeightBlocked;
+	RestoreHeightBlocked.Name = TEXT ("RestoreCollisionHeightAfterSlide.Blocked");
+	RestoreHeightBlocked.Prepare = [=] () {
+		Capsule->SetCapsuleSize (DefRadius, SlideHalfHeight);
+		Character->SetActorLocation (CeilingSlideLocation);
+	};
+	RestoreHeightBlocked.Run = [=] () {
+		MoveComp->RestoreCollisionHeightAfterSlide ();
+	};
+
+	FCase ClimbOverObstacle;
+	ClimbOverObstacle.Name = TEXT ("ClimbOverObstacle");
+	ClimbOverObstacle.Prepare = [=] () {
+		Capsule->SetCapsuleSize (DefRadius, DefHalfHeight);
+		Character->SetActorLocation (ObstacleLocation);
+		MoveComp->SetMovementMode (MOVE_Walking);
+	};
+	ClimbOverObstacle.Run = [=] () {
+		Character->ClimbOverObstacle ();
+	};
+
+	Cases.Add (PhysWalkingSlide);
+	Cases.Add (SetSlideHeight);
+	Cases.Add (RestoreHeightClear);
+	Cases.Add (RestoreHeightBlocked);
+	Cases.Add (ClimbOverObstacle);
+
+	// count allocations only while cases run
+	FMalloc* OriginalMalloc = GMalloc;
+	FCountingMalloc Counter (OriginalMalloc);
+	GMalloc = &Counter;
+
+	TArray<FResult> Results;
+	for (const FCase& Case : Cases) {
+		const FResult Result = RunCase (Case, Iterations, Counter);
+		UE_LOG (LogPlatformerBenchmark, Display, TEXT ("%-45s %10.1f ns/call %8.2f allocs/call"), *Result.Name, Result.NsPerCall, Result.AllocsPerCall);
+		Results.Add (Result);
+	}
+
+	GMalloc = OriginalMalloc;
+
+	// clear of test level geometry, long enough for the whole slide
+	const bool bSlideLODMatches = CheckSlideLOD (Character, MoveComp, FVector (-6000.0f, 4000.0f, SlideHalfHeight + 1.0f), SlideLODTolerance);
+
+	Level.Destroy ();
+
+	if (!WriteResults (OutputFile, Results, Iterations)) {
+		UE_LOG (LogPlatformerBenchmark, Error, TEXT ("Failed to write results to %s"), *OutputFile);
+		return 1;
+	}
+	UE_LOG (LogPlatformerBenchmark, Display, TEXT ("Results written to %s"), *OutputFile);
+
+	if (!BaselineFile.IsEmpty ()) {
+		TMap<FString, FResult> Baseline;
+		if (!ReadResults (BaselineFile, Baseline)) {
+			UE_LOG (LogPlatformerBenchmark, Error, TEXT ("Failed to read baseline %s"), *BaselineFile);
+			return 1;
+		}
+
+		const int32 NumRegressions = CompareResults (Results, Baseline, Tolerance);
+		if (NumRegressions > 0) {
+			UE_LOG (LogPlatformerBenchmark, Error, TEXT ("%d regression(s) against %s"), NumRegressions, *BaselineFile);
+			return 1;
+		}
+	}
+
+	return bSlideLODMatches ? 0 : 1;
+}
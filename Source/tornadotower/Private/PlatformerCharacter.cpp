@@ -5,12 +5,61 @@
 #include "../Public/PlatformerCharacter.h"
 #include "../Public/PlatformerPlayerMovementComp.h"
 #include "../Public/PlatformerPlayerController.h"
+#include "../Public/PlatformerObstacleIndex.h"
+#include "../Public/PlatformerClimbMarker.h"
+#include "../Public/PlatformerRoundManager.h"
+#include "../Public/PlatformerSignificanceManager.h"
+#include "../Public/PlatformerPerfCounters.h"
+#include "../Public/PlatformerLog.h"
+#include "../Public/PlatformerTrace.h"
+
+static void ListTickingCharacters (UWorld* World) {
+	int32 NumTicking = 0;
+	int32 NumTotal = 0;
+	for (TActorIterator<APlatformerCharacter> It (World); It; ++It) {
+		NumTotal++;
+		if (It->IsActorTickEnabled ()) {
+			NumTicking++;
+			UE_LOG (LogPlatformer, Display, TEXT ("%s: %s"), *It->GetName (), *It->DescribeTickReasons ());
+		}
+	}
+	UE_LOG (LogPlatformer, Display, TEXT ("%d of %d platformer characters ticking"), NumTicking, NumTotal);
+}
+
+/** time server waits for move of an obstacle hit that arrived before it */
+static const float MaxPendingObstacleHitTime = 1.0f;
+
+/** input is recorded or replayed for first possessed player pawn only */
+static bool GInputCaptureStarted = false;
+
+static FAutoConsoleCommandWithWorld ListTickingCharactersCommand (
+	TEXT ("Platformer.ListTickingCharacters"),
+	TEXT ("Lists platformer characters with actor tick enabled and why"),
+	FConsoleCommandWithWorldDelegate::CreateStatic (&ListTickingCharacters));
 
 APlatformerCharacter::APlatformerCharacter (const FObjectInitializer& ObjectInitializer)
 	: Super (ObjectInitializer.SetDefaultSubobjectClass<UPlatformerPlayerMovementComp> (ACharacter::CharacterMovementComponentName)) {
 	MinSpeedForHittingWall = 200.0f;
 	GetMesh ()->MeshComponentUpdateFlag = EMeshComponentUpdateFlag::AlwaysTickPoseAndRefreshBones;
 
+	// tick only while there is something to adjust, see EPlatformerTickReason
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
+	TickReasons = 0;
+
+	CameraHeightChangeThreshold = 250.0f;
+
+	MaxObstacleHitError = 50.0f;
+	MaxLookAheadHitTime = 0.1f;
+	PendingObstacleHitTimeStamp = 0.0f;
+	PendingObstacleHitReceiveTime = 0.0f;
+	bHasPendingObstacleHit = false;
+	bPendingObstacleHitLookAhead = false;
+
+	SignificanceHoldTime = 2.0f;
+	Significance = EPlatformerSignificance::High;
+	LastGameplayEventTime = -BIG_NUMBER;
+
 	// Set size for collision capsule
 	GetCapsuleComponent ()->InitCapsuleSize (42.f, 96.0f);
 
@@ -34,6 +83,7 @@ APlatformerCharacter::APlatformerCharacter (const FObjectInitializer& ObjectInit
 	CameraBoom->SetupAttachment (RootComponent);
 	CameraBoom->TargetArmLength = 300.0f; // The camera follows at this distance behind the character	
 	CameraBoom->bUsePawnControlRotation = true; // Rotate the arm based on the controller
+	CameraBoom->bDoCollisionTest = false; // APlatformerPlayerCameraManager probes only when pawn moved enough
 
 												// Create a follow camera
 	FollowCamera = CreateDefaultSubobject<UCameraComponent> (TEXT ("FollowCamera"));
@@ -51,11 +101,70 @@ void APlatformerCharacter::PostInitializeComponents () {
 	SetActorRotation (FRotator (0.0f, 0.0f, 0.0f));
 }
 
+void APlatformerCharacter::BeginPlay () {
+	Super::BeginPlay ();
+
+	ObstacleIndex = APlatformerObstacleIndex::Get (GetWorld ());
+	AudioPool = APlatformerAudioPool::Get (GetWorld ());
+	RoundManager = APlatformerRoundManager::Get (GetWorld ());
+
+	if (GetClass ()->IsFunctionImplementedInBlueprint (GET_FUNCTION_NAME_CHECKED (AActor, ReceiveTick))) {
+		AddTickReason (EPlatformerTickReason::Blueprint);
+	}
+
+	SignificanceManager = APlatformerSignificanceManager::Get (GetWorld ());
+	if (SignificanceManager.IsValid ()) {
+		SignificanceManager->RegisterCharacter (this);
+	}
+}
+
+void APlatformerCharacter::EndPlay (const EEndPlayReason::Type EndPlayReason) {
+	if (SignificanceManager.IsValid ()) {
+		SignificanceManager->UnregisterCharacter (this);
+	}
+
+	if (AudioPool.IsValid ()) {
+		AudioPool->Stop (SlideSoundHandle);
+	}
+
+	if (InputRecorder.IsValid ()) {
+		InputRecorder->Stop (this);
+		InputRecorder.Reset ();
+	}
+
+	Super::EndPlay (EndPlayReason);
+}
+
+void APlatformerCharacter::PossessedBy (AController* NewController) {
+	Super::PossessedBy (NewController);
+
+	APlayerController* PC = Cast<APlayerController> (NewController);
+	if (GInputCaptureStarted || !PC || !PC->IsLocalController ()) {
+		return;
+	}
+
+	FString Filename;
+	if (FParse::Value (FCommandLine::Get (), TEXT ("PlatformerReplay="), Filename)) {
+		GInputCaptureStarted = true;
+		InputReplay = MakeUnique<FPlatformerInputReplay> ();
+		if (InputReplay->Start (this, Filename)) {
+			AddTickReason (EPlatformerTickReason::InputReplay);
+		} else {
+			InputReplay.Reset ();
+			FPlatformMisc::RequestExit (false);
+		}
+	} else if (FParse::Value (FCommandLine::Get (), TEXT ("PlatformerRecord="), Filename)) {
+		GInputCaptureStarted = true;
+		InputRecorder = MakeUnique<FPlatformerInputRecorder> ();
+		InputRecorder->Start (this, Filename);
+	}
+}
+
 void APlatformerCharacter::SetupPlayerInputComponent (UInputComponent* PlayerInputComponent) {
 	PlayerInputComponent->BindAction ("Jump", IE_Pressed, this, &ACharacter::Jump);
 	PlayerInputComponent->BindAction ("Jump", IE_Released, this, &ACharacter::StopJumping);
-	//PlayerInputComponent->BindAction ("Slide", IE_Pressed, this, &APlatformerCharacter::OnStartSlide);
-	//PlayerInputComponent->BindAction ("Slide", IE_Released, this, &APlatformerCharacter::OnStopSlide);
+	PlayerInputComponent->BindAction ("Slide", IE_Pressed, this, &APlatformerCharacter::OnStartSlide);
+	PlayerInputComponent->BindAction ("Slide", IE_Released, this, &APlatformerCharacter::OnStopSlide);
 
 	PlayerInputComponent->BindAxis ("MoveForward", this, &APlatformerCharacter::MoveForward);
 	PlayerInputComponent->BindAxis ("MoveRight", this, &APlatformerCharacter::MoveRight);
@@ -68,8 +177,36 @@ void APlatformerCharacter::SetupPlayerInputComponent (UInputComponent* PlayerInp
 	PlayerInputComponent->BindAxis ("LookUpRate", this, &APlatformerCharacter::LookUpAtRate);*/
 }
 
+void APlatformerCharacter::Jump () {
+	if (InputRecorder.IsValid ()) {
+		InputRecorder->RecordAction (EPlatformerInputEvent::Jump);
+	}
+
+	// press starts or restarts round instead of jumping when round isn't running
+	APlatformerPlayerController* MyPC = Cast<APlatformerPlayerController> (Controller);
+	if (MyPC && MyPC->TryStartingGame ()) {
+		return;
+	}
+
+	// kept for a while, movement jumps once pawn can if press is recent enough
+	InputBuffer.PressJump (GetWorld ()->GetTimeSeconds ());
+	PLATFORMER_TRACE (JumpPressed, this);
+
+	Super::Jump ();
+}
+
+void APlatformerCharacter::StopJumping () {
+	if (InputRecorder.IsValid ()) {
+		InputRecorder->RecordAction (EPlatformerInputEvent::StopJumping);
+	}
+
+	PLATFORMER_TRACE (JumpReleased, this);
+	Super::StopJumping ();
+}
+
 void APlatformerCharacter::OnStartJump () {
-	UE_LOG (LogTemp, Warning, TEXT ("On Start Jumping!"));
+	PLATFORMER_HOT_LOG (Verbose, TEXT ("%s: start jump"), *GetName ());
+	PLATFORMER_TRACE (JumpPressed, this);
 
 	APlatformerPlayerController* MyPC = Cast<APlatformerPlayerController> (Controller);
 	if (MyPC) {
@@ -85,34 +222,33 @@ void APlatformerCharacter::OnStartJump () {
 }
 
 void APlatformerCharacter::OnStopJump () {
-	UE_LOG (LogTemp, Warning, TEXT ("On STOP Jumping!"));
+	PLATFORMER_HOT_LOG (Verbose, TEXT ("%s: stop jump"), *GetName ());
 
 	bPressedJump = false;
 	StopJumping ();
 }
 
 void APlatformerCharacter::MoveRight (float Value) {
-	if ((Controller != NULL) && (Value != 0.0f)) {
-		// find out which way is right
-		const FRotator Rotation = Controller->GetControlRotation ();
-		const FRotator YawRotation (0, Rotation.Yaw, 0);
+	if (InputRecorder.IsValid ()) {
+		InputRecorder->RecordAxis (EPlatformerInputEvent::MoveRight, Value);
+	}
 
-		// get right vector 
-		const FVector Direction = FRotationMatrix (YawRotation).GetUnitAxis (EAxis::Y);
-		// add movement in that direction
-		AddMovementInput (Direction, Value);
+	if ((Controller != NULL) && (Value != 0.0f)) {
+		// right vector of control yaw, shared with MoveForward
+		InputBuffer.UpdateYawBasis (Controller->GetControlRotation ().Yaw);
+		AddMovementInput (InputBuffer.GetRight (), Value);
 	}
 }
 
 void APlatformerCharacter::MoveForward (float Value) {
-	if ((Controller != NULL) && (Value != 0.0f)) {
-		// find out which way is forward
-		const FRotator Rotation = Controller->GetControlRotation ();
-		const FRotator YawRotation (0, Rotation.Yaw, 0);
+	if (InputRecorder.IsValid ()) {
+		InputRecorder->RecordAxis (EPlatformerInputEvent::MoveForward, Value);
+	}
 
-		// get forward vector
-		const FVector Direction = FRotationMatrix (YawRotation).GetUnitAxis (EAxis::X);
-		AddMovementInput (Direction, Value);
+	if ((Controller != NULL) && (Value != 0.0f)) {
+		// forward vector of control yaw, rebuilt only when yaw changes
+		InputBuffer.UpdateYawBasis (Controller->GetControlRotation ().Yaw);
+		AddMovementInput (InputBuffer.GetForward (), Value);
 	}
 }
 
@@ -153,11 +289,25 @@ void APlatformerCharacter::CheckJumpInput (float DeltaTime) {
 	Super::CheckJumpInput (DeltaTime);
 }
 
+bool APlatformerCharacter::CanJumpInternal_Implementation () const {
+	if (Super::CanJumpInternal_Implementation ()) {
+		return true;
+	}
+
+	// pawn which just ran off a ledge jumps as if it was still on it
+	const UPlatformerPlayerMovementComp* MoveComp = Cast<UPlatformerPlayerMovementComp> (GetCharacterMovement ());
+	return MoveComp && !bIsCrouched && MoveComp->IsJumpAllowed () && MoveComp->IsInCoyoteTime ();
+}
+
 void APlatformerCharacter::Tick (float DeltaSeconds) {
+	PLATFORMER_SCOPE_CYCLE_COUNTER (CharacterTick);
+
 	// decrease anim position adjustment
 	if (!AnimPositionAdjustment.IsNearlyZero ()) {
 		AnimPositionAdjustment = FMath::VInterpConstantTo (AnimPositionAdjustment, FVector::ZeroVector, DeltaSeconds, 400.0f);
 		GetMesh ()->SetRelativeLocation (GetBaseTranslationOffset () + AnimPositionAdjustment);
+	} else {
+		RemoveTickReason (EPlatformerTickReason::AnimPositionAdjustment);
 	}
 
 	if (ClimbToMarker) {
@@ -167,17 +317,82 @@ void APlatformerCharacter::Tick (float DeltaSeconds) {
 			SetActorLocation (GetActorLocation () + AdjustDelta, false);
 			ClimbToMarkerLocation += AdjustDelta;
 		}
+	} else {
+		RemoveTickReason (EPlatformerTickReason::ClimbToMarker);
+	}
+
+	if (InputReplay.IsValid () && !InputReplay->Tick (this)) {
+		FString ReportFilename;
+		FParse::Value (FCommandLine::Get (), TEXT ("PlatformerReplayReport="), ReportFilename);
+		InputReplay->Report (this, ReportFilename);
+		InputReplay.Reset ();
+		RemoveTickReason (EPlatformerTickReason::InputReplay);
+		FPlatformMisc::RequestExit (false);
 	}
 
 	Super::Tick (DeltaSeconds);
 
 }
 
+void APlatformerCharacter::AddTickReason (uint32 Reason) {
+	const bool bWasTicking = (TickReasons != 0);
+	TickReasons |= Reason;
+	if (!bWasTicking && TickReasons != 0) {
+		SetActorTickEnabled (true);
+	}
+}
+
+void APlatformerCharacter::RemoveTickReason (uint32 Reason) {
+	const bool bWasTicking = (TickReasons != 0);
+	TickReasons &= ~Reason;
+	if (bWasTicking && TickReasons == 0) {
+		SetActorTickEnabled (false);
+	}
+}
+
+uint32 APlatformerCharacter::GetTickReasons () const {
+	return TickReasons;
+}
+
+FString APlatformerCharacter::DescribeTickReasons () const {
+	FString Result;
+	if (TickReasons & EPlatformerTickReason::AnimPositionAdjustment) {
+		Result += TEXT ("AnimPositionAdjustment ");
+	}
+	if (TickReasons & EPlatformerTickReason::ClimbToMarker) {
+		Result += TEXT ("ClimbToMarker ");
+	}
+	if (TickReasons & EPlatformerTickReason::Blueprint) {
+		Result += TEXT ("Blueprint ");
+	}
+	if (TickReasons & EPlatformerTickReason::InputReplay) {
+		Result += TEXT ("InputReplay ");
+	}
+	return Result.IsEmpty () ? FString (TEXT ("none")) : Result.TrimTrailing ();
+}
+
+void APlatformerCharacter::SetAnimPositionAdjustment (const FVector& Adjustment) {
+	AnimPositionAdjustment = Adjustment;
+	GetMesh ()->SetRelativeLocation (GetBaseTranslationOffset () + AnimPositionAdjustment);
+	if (!AnimPositionAdjustment.IsNearlyZero ()) {
+		AddTickReason (EPlatformerTickReason::AnimPositionAdjustment);
+	}
+}
+
+void APlatformerCharacter::SetClimbToMarker (UStaticMeshComponent* Marker) {
+	ClimbToMarker = Marker;
+	ClimbToMarkerLocation = Marker ? Marker->GetComponentLocation () : FVector::ZeroVector;
+	if (ClimbToMarker) {
+		AddTickReason (EPlatformerTickReason::ClimbToMarker);
+	} else {
+		RemoveTickReason (EPlatformerTickReason::ClimbToMarker);
+	}
+}
+
 void APlatformerCharacter::PlayRoundFinished () {
-	//APlatformerGameMode* MyGame = GetWorld ()->GetAuthGameMode<APlatformerGameMode> ();
-	//const bool bWon = MyGame && MyGame->IsRoundWon ();
+	const bool bWon = RoundManager.IsValid () && RoundManager->IsRoundWon ();
 
-	//PlayAnimMontage (bWon ? WonMontage : LostMontage);
+	PlayAnimMontage (bWon ? WonMontage : LostMontage);
 
 	GetCharacterMovement ()->StopMovementImmediately ();
 	GetCharacterMovement ()->DisableMovement ();
@@ -192,71 +407,156 @@ void APlatformerCharacter::OnRoundFinished () {
 
 void APlatformerCharacter::OnRoundReset () {
 	// reset animations
-	/*if (GetMesh () && GetMesh ()->AnimScriptInstance) {
-	GetMesh ()->AnimScriptInstance->Montage_Stop (0.0f);
-	}*/
+	UAnimInstance* AnimInstance = GetMesh ()->GetAnimInstance ();
+	if (AnimInstance) {
+		AnimInstance->Montage_Stop (0.0f);
+	}
+	SetAnimPositionAdjustment (FVector::ZeroVector);
+	SetClimbToMarker (NULL);
 
-	// reset movement properties
-	GetCharacterMovement ()->StopMovementImmediately ();
-	GetCharacterMovement ()->SetMovementMode (MOVE_Walking);
+	// reset movement properties ; leaving custom mode ends vault or ledge climb
+	UPlatformerPlayerMovementComp* MyMovement = Cast<UPlatformerPlayerMovementComp> (GetCharacterMovement ());
+	MyMovement->StopMovementImmediately ();
+	MyMovement->SetMovementMode (MOVE_Walking);
+	MyMovement->ResetForRound ();
+	bHasPendingObstacleHit = false;
 	bPressedJump = false;
 	bPressedSlide = false;
+	InputBuffer.Reset ();
+}
+
+void APlatformerCharacter::Landed (const FHitResult& Hit) {
+	Super::Landed (Hit);
+
+	if (RoundManager.IsValid () && RoundManager->GetRoundState () == EPlatformerRoundState::Finished) {
+		PlayRoundFinished ();
+	}
 }
-//
-//void APlatformerCharacter::Landed (const FHitResult& Hit) {
-//	Landed (Hit);
-//
-//	//APlatformerGameMode* MyGame = GetWorld ()->GetAuthGameMode<APlatformerGameMode> ();
-//	//if (MyGame && MyGame->GetGameState () == EGameState::Finished) {
-//	PlayRoundFinished ();
-//	//}
-//}
 
 void APlatformerCharacter::MoveBlockedBy (const FHitResult& Impact) {
+	PLATFORMER_SCOPE_CYCLE_COUNTER (MoveBlockedBy);
+
 	const float ForwardDot = FVector::DotProduct (Impact.Normal, FVector::ForwardVector);
-	if (GetCharacterMovement ()->MovementMode != MOVE_None) {
-		/*UE_LOG (LogPlatformer, Log, TEXT ("Collision with %s, normal=(%f,%f,%f), dot=%f, %s"),
+	PLATFORMER_HOT_LOG (VeryVerbose, TEXT ("%s: collision with %s, normal=(%f,%f,%f), dot=%f, %s"), *GetName (),
 		*GetNameSafe (Impact.Actor.Get ()),
 		Impact.Normal.X, Impact.Normal.Y, Impact.Normal.Z,
 		ForwardDot,
-		*GetCharacterMovement ()->GetMovementName ());*/
-	}
+		*GetCharacterMovement ()->GetMovementName ());
 
 	if (GetCharacterMovement ()->MovementMode == MOVE_Walking && ForwardDot < -0.9f) {
 		UPlatformerPlayerMovementComp* MyMovement = Cast<UPlatformerPlayerMovementComp> (GetCharacterMovement ());
 		const float Speed = FMath::Abs (FVector::DotProduct (MyMovement->Velocity, FVector::ForwardVector));
 		// if running or sliding: play bump reaction and jump over obstacle
 
-		float Duration = 0.01f;
-		if (Speed > MinSpeedForHittingWall) {
-			Duration = PlayAnimMontage (HitWallMontage);
+		// owning client reacts right away and lets server confirm with lag compensation
+		if (Role == ROLE_AutonomousProxy) {
+			ServerObstacleHit (MyMovement->GetClientMoveTimeStamp (), false);
 		}
-		GetWorldTimerManager ().SetTimer (TimerHandle_ClimbOverObstacle, this, &APlatformerCharacter::ClimbOverObstacle, Duration, false);
-		MyMovement->PauseMovementForObstacleHit ();
+
+		StartObstacleHit (Impact.GetComponent (), Speed, false);
 	}
-	//else if (GetCharacterMovement ()->MovementMode == MOVE_Falling) {
-	//	// if in mid air: try climbing to hit marker
-	//	APlatformerClimbMarker* Marker = Cast<APlatformerClimbMarker> (Impact.Actor.Get ());
-	//	if (Marker) {
-	//		ClimbToLedge (Marker);
+	// in mid air, ledges in reach are grabbed by movement before every falling step
+}
 
-	//		UPlatformerPlayerMovementComp* MyMovement = Cast<UPlatformerPlayerMovementComp> (GetCharacterMovement ());
-	//		MyMovement->PauseMovementForLedgeGrab ();
-	//	}
-	//}
+void APlatformerCharacter::OnObstacleAhead (const FHitResult& Hit) {
+	UPlatformerPlayerMovementComp* MyMovement = Cast<UPlatformerPlayerMovementComp> (GetCharacterMovement ());
+	const float Speed = FMath::Abs (FVector::DotProduct (MyMovement->Velocity, FVector::ForwardVector));
+
+	if (Role == ROLE_AutonomousProxy) {
+		ServerObstacleHit (MyMovement->GetClientMoveTimeStamp (), true);
+	}
+
+	StartObstacleHit (Hit.GetComponent (), Speed, true);
 }
 
-void APlatformerCharacter::ResumeMovement () {
-	SetActorEnableCollision (true);
+bool APlatformerCharacter::ServerObstacleHit_Validate (float ClientTimeStamp, bool bLookAhead) {
+	return true;
+}
+
+void APlatformerCharacter::ServerObstacleHit_Implementation (float ClientTimeStamp, bool bLookAhead) {
+	UPlatformerPlayerMovementComp* MyMovement = Cast<UPlatformerPlayerMovementComp> (GetCharacterMovement ());
+	if (!MyMovement) {
+		return;
+	}
+
+	// reliable hit can overtake unreliable move it happened in, wait until that move is simulated
+	if (MyMovement->IsClientMoveAhead (ClientTimeStamp)) {
+		PendingObstacleHitTimeStamp = ClientTimeStamp;
+		PendingObstacleHitReceiveTime = GetWorld ()->GetTimeSeconds ();
+		bHasPendingObstacleHit = true;
+		bPendingObstacleHitLookAhead = bLookAhead;
+		return;
+	}
+
+	bHasPendingObstacleHit = false;
+	ConfirmObstacleHit (ClientTimeStamp, bLookAhead);
+}
+
+void APlatformerCharacter::OnClientMoveProcessed (float ClientTimeStamp) {
+	if (!bHasPendingObstacleHit) {
+		return;
+	}
+
+	// move was lost or client time stamps were reset
+	if (GetWorld ()->GetTimeSeconds () - PendingObstacleHitReceiveTime > MaxPendingObstacleHitTime) {
+		bHasPendingObstacleHit = false;
+		return;
+	}
+
+	if (ClientTimeStamp >= PendingObstacleHitTimeStamp) {
+		bHasPendingObstacleHit = false;
+		ConfirmObstacleHit (PendingObstacleHitTimeStamp, bPendingObstacleHitLookAhead);
+	}
+}
+
+void APlatformerCharacter::ConfirmObstacleHit (float ClientTimeStamp, bool bLookAhead) {
+	// server simulation may have found the obstacle first
+	UPlatformerPlayerMovementComp* MyMovement = Cast<UPlatformerPlayerMovementComp> (GetCharacterMovement ());
+	if (MyMovement->MovementMode != MOVE_Walking) {
+		return;
+	}
 
+	FPlatformerMovementSnapshot Snapshot;
+	if (!MyMovement->GetMovementSnapshot (ClientTimeStamp, Snapshot) || Snapshot.MovementMode != MOVE_Walking) {
+		return;
+	}
+
+	// client's word isn't taken for the obstacle: rewound capsule has to be touching a wall in front of it,
+	// or server's own look-ahead sweep along rewound velocity has to reach one within MaxLookAheadHitTime
+	const FVector SweepDir = bLookAhead ? Snapshot.Velocity.GetSafeNormal2D () : FVector::ForwardVector;
+	const float SweepDist = MaxObstacleHitError + (bLookAhead ? Snapshot.Velocity.Size2D () * MaxLookAheadHitTime : 0.0f);
+	FHitResult Hit;
+	if (SweepDir.IsZero () || !MyMovement->FindObstacleAhead (Snapshot.Location, Snapshot.CapsuleHalfHeight, SweepDir, SweepDist, Hit)) {
+		return;
+	}
+
+	// vault starts from current location, moving pawn back would snap it on every client
+	StartObstacleHit (Hit.GetComponent (), FMath::Abs (FVector::DotProduct (Snapshot.Velocity, FVector::ForwardVector)), bLookAhead);
+}
+
+void APlatformerCharacter::StartObstacleHit (UPrimitiveComponent* HitComponent, float Speed, bool bLookAhead) {
+	PLATFORMER_TRACE (ObstacleHit, this, Speed, 0.0f, bLookAhead ? 1 : 0);
+
+	ObstacleHitComponent = HitComponent;
+	MarkGameplayRelevant ();
+
+	const float HitReactionTime = (!bLookAhead && Speed > MinSpeedForHittingWall) ? PlayAnimMontage (HitWallMontage) : 0.0f;
+
+	UPlatformerPlayerMovementComp* MyMovement = Cast<UPlatformerPlayerMovementComp> (GetCharacterMovement ());
+	MyMovement->StartVault (HitComponent, HitReactionTime, bLookAhead);
+}
+
+void APlatformerCharacter::ResumeMovement () {
 	// restore movement state and saved speed
 	UPlatformerPlayerMovementComp* MyMovement = Cast<UPlatformerPlayerMovementComp> (GetCharacterMovement ());
 	MyMovement->RestoreMovement ();
 
-	ClimbToMarker = NULL;
+	SetClimbToMarker (NULL);
 }
 
-void APlatformerCharacter::ClimbOverObstacle () {
+float APlatformerCharacter::ClimbOverObstacle () {
+	PLATFORMER_SCOPE_CYCLE_COUNTER (ClimbOverObstacle);
+
 	// climbing over obstacle:
 	// - there are three animations matching with three types of predefined obstacle heights
 	// - pawn is moved using root motion, ending up on top of obstacle as animation ends
@@ -265,34 +565,168 @@ void APlatformerCharacter::ClimbOverObstacle () {
 	const FVector TraceStart = GetActorLocation () + ForwardDir * 150.0f + FVector (0, 0, 1) * (GetCapsuleComponent ()->GetScaledCapsuleHalfHeight () + 150.0f);
 	const FVector TraceEnd = TraceStart + FVector (0, 0, -1) * 500.0f;
 
-	FCollisionQueryParams TraceParams (NAME_None, true);
-	FHitResult Hit;
-	GetWorld ()->LineTraceSingleByChannel (Hit, TraceStart, TraceEnd, ECC_Pawn, TraceParams);
-
-	if (Hit.bBlockingHit) {
-		const FVector DestPosition = Hit.ImpactPoint + FVector (0, 0, GetCapsuleComponent ()->GetScaledCapsuleHalfHeight ());
-		const float ZDiff = DestPosition.Z - GetActorLocation ().Z;
-		/*UE_LOG (LogPlatformer, Log, TEXT ("Climb over obstacle, Z difference: %f (%s)"), ZDiff,
-		(ZDiff < ClimbOverMidHeight) ? TEXT ("small") : (ZDiff < ClimbOverBigHeight) ? TEXT ("mid") : TEXT ("big"));*/
-
-		UAnimMontage* Montage = (ZDiff < ClimbOverMidHeight) ? ClimbOverSmallMontage : (ZDiff < ClimbOverBigHeight) ? ClimbOverMidMontage : ClimbOverBigMontage;
-
-		// set flying mode since it needs Z changes. If Walking or Falling, we won't be able to apply Z changes
-		// this gets reset in the ResumeMovement
-		GetCharacterMovement ()->SetMovementMode (MOVE_Flying);
-		SetActorEnableCollision (false);
-		const float Duration = PlayAnimMontage (Montage);
-		GetWorldTimerManager ().SetTimer (TimerHandle_ResumeMovement, this, &APlatformerCharacter::ResumeMovement, Duration - 0.1f, false);
-	} else {
-		// shouldn't happen
-		ResumeMovement ();
+	// static obstacles are looked up in baked index, anything else needs a trace
+	bool bFoundTop = false;
+	float TopZ = 0.0f;
+	{
+		PLATFORMER_SCOPE_CYCLE_COUNTER (CollisionQuery);
+
+		const UPrimitiveComponent* HitComponent = ObstacleHitComponent.Get ();
+		if (ObstacleIndex.IsValid () && HitComponent && HitComponent->Mobility == EComponentMobility::Static) {
+			FPlatformerObstacleTop ObstacleTop;
+			// top at trace point may belong to another obstacle behind the one hit
+			if (ObstacleIndex->FindObstacleTop (TraceStart, TraceEnd.Z, TraceStart.Z, ObstacleTop) && ObstacleTop.Component.Get () == HitComponent) {
+				bFoundTop = true;
+				TopZ = ObstacleTop.TopZ;
+			}
+		}
+
+		if (!bFoundTop) {
+			PLATFORMER_INC_CALL_COUNTER (Traces);
+			FCollisionQueryParams TraceParams (NAME_None, true);
+			FHitResult Hit;
+			GetWorld ()->LineTraceSingleByChannel (Hit, TraceStart, TraceEnd, ECC_Pawn, TraceParams);
+
+			bFoundTop = Hit.bBlockingHit;
+			TopZ = Hit.ImpactPoint.Z;
+		}
 	}
+
+	if (bFoundTop) {
+		const float ZDiff = TopZ + GetCapsuleComponent ()->GetScaledCapsuleHalfHeight () - GetActorLocation ().Z;
+		const EPlatformerObstacleClass ObstacleClass = ClassifyObstacleHeight (ZDiff);
+		PLATFORMER_HOT_LOG (Verbose, TEXT ("%s: climb over obstacle, Z difference: %f (%s)"), *GetName (), ZDiff,
+			(ObstacleClass == EPlatformerObstacleClass::Small) ? TEXT ("small") : (ObstacleClass == EPlatformerObstacleClass::Mid) ? TEXT ("mid") : TEXT ("big"));
+		PLATFORMER_TRACE (Vault, this, ZDiff, 0.0f, (uint8)ObstacleClass);
+
+		UAnimMontage* Montage = NULL;
+		switch (ObstacleClass) {
+			case EPlatformerObstacleClass::Small:
+				Montage = ClimbOverSmallMontage;
+				break;
+
+			case EPlatformerObstacleClass::Mid:
+				Montage = ClimbOverMidMontage;
+				break;
+
+			case EPlatformerObstacleClass::Big:
+				Montage = ClimbOverBigMontage;
+				break;
+		}
+
+		// vault movement mode applies Z changes of root motion, walking would drop them
+		return PlayAnimMontage (Montage);
+	}
+
+	return 0.0f;
+}
+
+bool APlatformerCharacter::CanClimbToLedge (const APlatformerClimbMarker* MoveToMarker) const {
+	return MoveToMarker && MoveToMarker->GetMesh () && ClimbLedgeMontage && GetMesh ()->GetAnimInstance ();
+}
+
+float APlatformerCharacter::ClimbToLedge (const APlatformerClimbMarker* MoveToMarker) {
+	if (!CanClimbToLedge (MoveToMarker)) {
+		return 0.0f;
+	}
+	UStaticMeshComponent* MarkerMesh = MoveToMarker->GetMesh ();
+
+	MarkGameplayRelevant ();
+	SetClimbToMarker (MarkerMesh);
+
+	// place on top left corner of marker, but preserve current Y coordinate
+	const FBox MarkerBox = MoveToMarker->GetLedgeBounds ();
+	const FVector DesiredPosition (MarkerBox.Min.X, GetActorLocation ().Y, MarkerBox.Max.Z);
+
+	// climbing to ledge:
+	// - pawn is placed on top of ledge (using ClimbLedgeGrabOffsetX to offset from grab point) immediately
+	// - AnimPositionAdjustment modifies mesh relative location to smooth transition
+	//   (mesh starts roughly at the same position, additional offset quickly decreases to zero in Tick)
+	const FVector StartPosition = GetActorLocation ();
+	FVector EndPosition = DesiredPosition + FVector (ClimbLedgeGrabOffsetX, 0.0f, 0.0f);
+	EndPosition.Z += GetCapsuleComponent ()->GetScaledCapsuleHalfHeight ();
+
+	SetActorLocation (EndPosition, false);
+	SetAnimPositionAdjustment (StartPosition - (EndPosition - ClimbLedgeRootOffset));
+
+	return PlayAnimMontage (ClimbLedgeMontage);
+}
+
+EPlatformerObstacleClass APlatformerCharacter::ClassifyObstacleHeight (float Height) const {
+	return (Height < ClimbOverMidHeight) ? EPlatformerObstacleClass::Small : (Height < ClimbOverBigHeight) ? EPlatformerObstacleClass::Mid : EPlatformerObstacleClass::Big;
+}
+
+float APlatformerCharacter::GetClimbOverDuration (EPlatformerObstacleClass Class) const {
+	const UAnimMontage* Montage =
+		(Class == EPlatformerObstacleClass::Small) ? ClimbOverSmallMontage :
+		(Class == EPlatformerObstacleClass::Mid) ? ClimbOverMidMontage :
+		ClimbOverBigMontage;
+
+	return Montage ? Montage->GetPlayLength () : 0.0f;
+}
+
+void APlatformerCharacter::SetSignificance (EPlatformerSignificance NewSignificance) {
+	if (Significance == NewSignificance) {
+		return;
+	}
+	Significance = NewSignificance;
+
+	const float ActorTickInterval = SignificanceManager.IsValid () ? SignificanceManager->GetActorTickInterval (NewSignificance) : 0.0f;
+	const float AnimTickInterval = SignificanceManager.IsValid () ? SignificanceManager->GetAnimTickInterval (NewSignificance) : 0.0f;
+
+	switch (NewSignificance) {
+		case EPlatformerSignificance::High:
+			GetMesh ()->MeshComponentUpdateFlag = EMeshComponentUpdateFlag::AlwaysTickPoseAndRefreshBones;
+			break;
+
+		case EPlatformerSignificance::Medium:
+			GetMesh ()->MeshComponentUpdateFlag = EMeshComponentUpdateFlag::AlwaysTickPose;
+			break;
+
+		case EPlatformerSignificance::Low:
+			GetMesh ()->MeshComponentUpdateFlag = EMeshComponentUpdateFlag::OnlyTickPoseWhenRendered;
+			break;
+	}
+
+	PrimaryActorTick.TickInterval = ActorTickInterval;
+	GetMesh ()->PrimaryComponentTick.TickInterval = AnimTickInterval;
+}
+
+EPlatformerSignificance APlatformerCharacter::GetSignificance () const {
+	return Significance;
+}
+
+bool APlatformerCharacter::IsGameplayRelevant () const {
+	if (IsPlayerControlled () || ClimbToMarker) {
+		return true;
+	}
+
+	const UPlatformerPlayerMovementComp* MoveComp = Cast<UPlatformerPlayerMovementComp> (GetCharacterMovement ());
+	if (MoveComp && (MoveComp->IsSliding () || MoveComp->IsVaulting () || MoveComp->MovementMode == MOVE_None)) {
+		return true;
+	}
+
+	const UAnimInstance* AnimInstance = GetMesh ()->GetAnimInstance ();
+	if (AnimInstance && AnimInstance->IsAnyMontagePlaying ()) {
+		return true;
+	}
+
+	return GetWorld ()->GetTimeSeconds () - LastGameplayEventTime < SignificanceHoldTime;
+}
+
+void APlatformerCharacter::MarkGameplayRelevant () {
+	LastGameplayEventTime = GetWorld ()->GetTimeSeconds ();
+	SetSignificance (EPlatformerSignificance::High);
 }
 
 void APlatformerCharacter::OnStartSlide () {
-	
-	UE_LOG (LogTemp, Warning, TEXT ("On Start Sliding!"));
-	
+	if (InputRecorder.IsValid ()) {
+		InputRecorder->RecordAction (EPlatformerInputEvent::StartSlide);
+	}
+
+	PLATFORMER_HOT_LOG (Verbose, TEXT ("%s: start slide"), *GetName ());
+	PLATFORMER_TRACE (SlidePressed, this);
+
 	APlatformerPlayerController* MyPC = Cast<APlatformerPlayerController> (Controller);
 	if (MyPC) {
 		if (MyPC->TryStartingGame ()) {
@@ -302,13 +736,17 @@ void APlatformerCharacter::OnStartSlide () {
 		// if && MyGame->IsRoundInProgress ()
 		if (!MyPC->IsMoveInputIgnored ()) {
 			bPressedSlide = true;
+			InputBuffer.PressSlide (GetWorld ()->GetTimeSeconds ());
 		}
 	}
 }
 
 void APlatformerCharacter::PlaySlideStarted () {
-	if (SlideSound) {
-		SlideAC = UGameplayStatics::SpawnSoundAttached (SlideSound, GetMesh ());
+	MarkGameplayRelevant ();
+
+	if (SlideSound && AudioPool.IsValid ()) {
+		AudioPool->Stop (SlideSoundHandle);
+		SlideSoundHandle = AudioPool->Play (SlideSound, GetMesh ());
 	}
 }
 
@@ -316,19 +754,27 @@ bool APlatformerCharacter::WantsToSlide () {
 	return bPressedSlide;
 }
 
-float APlatformerCharacter::GetCameraHeightChangeThreshold () {
+void APlatformerCharacter::SetWantsToSlide (bool bWants) {
+	bPressedSlide = bWants;
+}
+
+float APlatformerCharacter::GetCameraHeightChangeThreshold () const {
 	return CameraHeightChangeThreshold;
 }
 
 void APlatformerCharacter::OnStopSlide () {
-	UE_LOG (LogTemp, Warning, TEXT ("On STOP Sliding!"));
+	if (InputRecorder.IsValid ()) {
+		InputRecorder->RecordAction (EPlatformerInputEvent::StopSlide);
+	}
+
+	PLATFORMER_HOT_LOG (Verbose, TEXT ("%s: stop slide"), *GetName ());
+	PLATFORMER_TRACE (SlideReleased, this);
 
 	bPressedSlide = false;
 }
 
 void APlatformerCharacter::PlaySlideFinished () {
-	if (SlideAC) {
-		SlideAC->Stop ();
-		SlideAC = NULL;
+	if (AudioPool.IsValid ()) {
+		AudioPool->Stop (SlideSoundHandle);
 	}
 }
\ No newline at end of file
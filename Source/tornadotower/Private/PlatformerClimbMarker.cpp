@@ -0,0 +1,141 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "tornadotower.h"
+#include "../Public/PlatformerClimbMarker.h"
+
+APlatformerClimbMarker::APlatformerClimbMarker (const FObjectInitializer& ObjectInitializer)
+	: Super (ObjectInitializer) {
+	Mesh = CreateDefaultSubobject<UStaticMeshComponent> (TEXT ("Mesh"));
+	Mesh->SetCollisionProfileName (UCollisionProfile::BlockAll_ProfileName);
+	RootComponent = Mesh;
+
+	RegistryEntry = INDEX_NONE;
+}
+
+void APlatformerClimbMarker::BeginPlay () {
+	Super::BeginPlay ();
+
+	Registry = APlatformerClimbMarkerRegistry::Get (GetWorld ());
+	if (Registry.IsValid ()) {
+		Registry->RegisterMarker (this);
+	}
+}
+
+void APlatformerClimbMarker::EndPlay (const EEndPlayReason::Type EndPlayReason) {
+	if (Registry.IsValid ()) {
+		Registry->UnregisterMarker (this);
+	}
+
+	Super::EndPlay (EndPlayReason);
+}
+
+FBox APlatformerClimbMarker::GetLedgeBounds () const {
+	return Mesh->Bounds.GetBox ();
+}
+
+APlatformerClimbMarkerRegistry::APlatformerClimbMarkerRegistry (const FObjectInitializer& ObjectInitializer)
+	: Super (ObjectInitializer) {
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
+
+	CellSize = 400.0f;
+	NumMovable = 0;
+}
+
+APlatformerClimbMarkerRegistry* APlatformerClimbMarkerRegistry::Get (UWorld* World) {
+	if (!World || !World->IsGameWorld ()) {
+		return nullptr;
+	}
+
+	for (TActorIterator<APlatformerClimbMarkerRegistry> It (World); It; ++It) {
+		return *It;
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	return World->SpawnActor<APlatformerClimbMarkerRegistry> (SpawnParams);
+}
+
+void APlatformerClimbMarkerRegistry::PostInitializeComponents () {
+	Super::PostInitializeComponents ();
+
+	Grid.Init (FMath::Max (CellSize, 1.0f));
+}
+
+void APlatformerClimbMarkerRegistry::RegisterMarker (APlatformerClimbMarker* Marker) {
+	if (!Marker || Marker->RegistryEntry != INDEX_NONE) {
+		return;
+	}
+
+	const int32 EntryIdx = FreeEntries.Num () ? FreeEntries.Pop (false) : Entries.AddDefaulted ();
+	FPlatformerClimbMarkerEntry& Entry = Entries[EntryIdx];
+	Entry.Marker = Marker;
+	Entry.Bounds = Marker->GetLedgeBounds ();
+	Entry.bMovable = (Marker->GetMesh ()->Mobility == EComponentMobility::Movable);
+	Marker->RegistryEntry = EntryIdx;
+
+	Grid.Add (EntryIdx, Entry.Bounds);
+
+	if (Entry.bMovable && NumMovable++ == 0) {
+		SetActorTickEnabled (true);
+	}
+}
+
+void APlatformerClimbMarkerRegistry::UnregisterMarker (APlatformerClimbMarker* Marker) {
+	if (!Marker || !Entries.IsValidIndex (Marker->RegistryEntry)) {
+		return;
+	}
+
+	const int32 EntryIdx = Marker->RegistryEntry;
+	FPlatformerClimbMarkerEntry& Entry = Entries[EntryIdx];
+	Grid.Remove (EntryIdx, Entry.Bounds);
+
+	if (Entry.bMovable && --NumMovable == 0) {
+		SetActorTickEnabled (false);
+	}
+
+	Entry = FPlatformerClimbMarkerEntry ();
+	FreeEntries.Add (EntryIdx);
+	Marker->RegistryEntry = INDEX_NONE;
+}
+
+void APlatformerClimbMarkerRegistry::Tick (float DeltaSeconds) {
+	Super::Tick (DeltaSeconds);
+
+	for (int32 EntryIdx = 0; EntryIdx < Entries.Num (); EntryIdx++) {
+		FPlatformerClimbMarkerEntry& Entry = Entries[EntryIdx];
+		const APlatformerClimbMarker* Marker = Entry.Marker.Get ();
+		if (!Entry.bMovable || !Marker) {
+			continue;
+		}
+
+		const FBox NewBounds = Marker->GetLedgeBounds ();
+		if (!NewBounds.Min.Equals (Entry.Bounds.Min) || !NewBounds.Max.Equals (Entry.Bounds.Max)) {
+			Grid.Remove (EntryIdx, Entry.Bounds);
+			Entry.Bounds = NewBounds;
+			Grid.Add (EntryIdx, Entry.Bounds);
+		}
+	}
+}
+
+APlatformerClimbMarker* APlatformerClimbMarkerRegistry::FindLedge (const FBox& GrabBounds) const {
+	APlatformerClimbMarker* Best = NULL;
+	float BestX = MAX_flt;
+
+	Grid.ForEachInBounds (GrabBounds, [&] (int32 EntryIdx) {
+		const FPlatformerClimbMarkerEntry& Entry = Entries[EntryIdx];
+		const FBox& Bounds = Entry.Bounds;
+
+		// grab point is top front edge of marker
+		if (Bounds.Min.X >= GrabBounds.Min.X && Bounds.Min.X <= GrabBounds.Max.X &&
+			Bounds.Max.Z >= GrabBounds.Min.Z && Bounds.Max.Z <= GrabBounds.Max.Z &&
+			Bounds.Max.Y >= GrabBounds.Min.Y && Bounds.Min.Y <= GrabBounds.Max.Y &&
+			Bounds.Min.X < BestX && Entry.Marker.IsValid ())
+		{
+			Best = Entry.Marker.Get ();
+			BestX = Bounds.Min.X;
+		}
+	});
+
+	return Best;
+}
@@ -0,0 +1,361 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "tornadotower.h"
+#include "../Public/PlatformerCrowd.h"
+#include "../Public/PlatformerCharacter.h"
+#include "../Public/PlatformerPlayerMovementComp.h"
+#include "../Public/PlatformerSlideKernel.h"
+#include "../Public/PlatformerPerfCounters.h"
+
+DEFINE_LOG_CATEGORY_STATIC (LogPlatformerCrowd, Log, All);
+
+APlatformerCrowd::APlatformerCrowd (const FObjectInitializer& ObjectInitializer)
+	: Super (ObjectInitializer) {
+	PrimaryActorTick.bCanEverTick = true;
+
+	Instances = ObjectInitializer.CreateDefaultSubobject<UInstancedStaticMeshComponent> (this, TEXT ("Instances"));
+	Instances->SetMobility (EComponentMobility::Movable);
+	Instances->SetCollisionEnabled (ECollisionEnabled::NoCollision);
+	Instances->SetCastShadow (false);
+	RootComponent = Instances;
+
+	RunnerClass = APlatformerCharacter::StaticClass ();
+	NumRunners = 1000;
+	CourseLength = 18000.0f;
+	CourseWidth = 2000.0f;
+	SlideChance = 0.3f;
+	DefaultClimbDuration = 1.0f;
+
+	RunnerMesh = NULL;
+	NumAnimationFrames = 1;
+	AnimationFrameRate = 30.0f;
+	SlideClip.bLoop = false;
+	ClimbOverSmallClip.bLoop = false;
+	ClimbOverMidClip.bLoop = false;
+	ClimbOverBigClip.bLoop = false;
+
+	RunSpeed = 0.0f;
+	RunAcceleration = 0.0f;
+	SlideReductionRate = 0.0f;
+	MinSlideSpeed = 0.0f;
+	MaxSlideSpeed = 0.0f;
+	ObstacleHitSpeedScale = 0.0f;
+	LookAheadVaultSpeedScale = 0.0f;
+	LookAheadMinSpeed = 0.0f;
+	GravityZ = 0.0f;
+	StepHeight = 0.0f;
+	Radius = 0.0f;
+	HalfHeight = 0.0f;
+	ClimbDurations[0] = ClimbDurations[1] = ClimbDurations[2] = 0.0f;
+	GroundZ = 0.0f;
+	RunnerDefaults = NULL;
+}
+
+void APlatformerCrowd::BeginPlay () {
+	Super::BeginPlay ();
+
+	if (GetNetMode () == NM_DedicatedServer) {
+		SetActorTickEnabled (false);
+		return;
+	}
+
+	ReadRunnerRules ();
+
+	ObstacleIndex = APlatformerObstacleIndex::Get (GetWorld ());
+	if (!ObstacleIndex.IsValid ()) {
+		UE_LOG (LogPlatformerCrowd, Warning, TEXT ("%s: level has no baked obstacle index, crowd runners won't vault"), *GetName ());
+	}
+
+	Instances->SetStaticMesh (RunnerMesh);
+	Random.Initialize (GetUniqueID ());
+	ResetRunners ();
+}
+
+void APlatformerCrowd::ReadRunnerRules () {
+	const UClass* Class = RunnerClass ? *RunnerClass : APlatformerCharacter::StaticClass ();
+	const APlatformerCharacter* DefCharacter = Class->GetDefaultObject<APlatformerCharacter> ();
+	RunnerDefaults = DefCharacter;
+
+	const UPlatformerPlayerMovementComp* DefMovement = CastChecked<UPlatformerPlayerMovementComp> (DefCharacter->GetCharacterMovement ());
+
+	RunSpeed = DefMovement->MaxWalkSpeed;
+	RunAcceleration = DefMovement->MaxAcceleration;
+	SlideReductionRate = DefMovement->SlideVelocityReduction;
+	MinSlideSpeed = DefMovement->MinSlideSpeed;
+	MaxSlideSpeed = DefMovement->MaxSlideSpeed;
+	ObstacleHitSpeedScale = DefMovement->ModSpeedObstacleHit;
+	LookAheadVaultSpeedScale = DefMovement->bEnableLookAheadVault ? DefMovement->ModSpeedLookAheadVault : DefMovement->ModSpeedObstacleHit;
+	LookAheadMinSpeed = DefMovement->LookAheadMinSpeed;
+	GravityZ = GetWorld ()->GetGravityZ () * DefMovement->GravityScale;
+	StepHeight = DefMovement->MaxStepHeight;
+	Radius = DefCharacter->GetCapsuleComponent ()->GetScaledCapsuleRadius ();
+	HalfHeight = DefCharacter->GetCapsuleComponent ()->GetScaledCapsuleHalfHeight ();
+
+	ClimbDurations[(int32)EPlatformerObstacleClass::Small] = DefCharacter->GetClimbOverDuration (EPlatformerObstacleClass::Small);
+	ClimbDurations[(int32)EPlatformerObstacleClass::Mid] = DefCharacter->GetClimbOverDuration (EPlatformerObstacleClass::Mid);
+	ClimbDurations[(int32)EPlatformerObstacleClass::Big] = DefCharacter->GetClimbOverDuration (EPlatformerObstacleClass::Big);
+}
+
+void APlatformerCrowd::ResetRunners () {
+	const int32 Num = FMath::Max (NumRunners, 0);
+	const FVector Origin = GetActorLocation ();
+	GroundZ = Origin.Z;
+
+	PosX.SetNumUninitialized (Num);
+	PosY.SetNumUninitialized (Num);
+	PosZ.Init (GroundZ, Num);
+	Speed.SetNumUninitialized (Num);
+	VelZ.Init (0.0f, Num);
+	FloorZ.Init (GroundZ, Num);
+	FloorEndX.Init (MAX_flt, Num);
+	SlideReduction.Init (0.0f, Num);
+	StateTime.SetNumUninitialized (Num);
+	VaultStartX.Init (0.0f, Num);
+	VaultStartZ.Init (0.0f, Num);
+	VaultEndX.Init (0.0f, Num);
+	VaultEndZ.Init (0.0f, Num);
+	VaultDuration.Init (0.0f, Num);
+	State.Init (EPlatformerCrowdState::Run, Num);
+	VaultClass.Init ((uint8)EPlatformerObstacleClass::Small, Num);
+
+	for (int32 Runner = 0; Runner < Num; Runner++) {
+		PosX[Runner] = Origin.X + Random.FRandRange (0.0f, CourseLength);
+		PosY[Runner] = Origin.Y + Random.FRandRange (-0.5f, 0.5f) * CourseWidth;
+		Speed[Runner] = Random.FRandRange (0.5f, 1.0f) * RunSpeed;
+
+		// random phase, so runners don't step in sync
+		StateTime[Runner] = Random.FRandRange (0.0f, 10.0f);
+	}
+
+	// slide batch constants ; sliders run along X on flat ground
+	SlideFloorNormalX.Init (0.0f, Num);
+	SlideFloorNormalY.Init (0.0f, Num);
+	SlideFloorNormalZ.Init (1.0f, Num);
+	SlideReductionRates.Init (SlideReductionRate, Num);
+	SlideMinSpeeds.Init (MinSlideSpeed, Num);
+	SlideMaxSpeeds.Init (MaxSlideSpeed, Num);
+	SlideVelocityY.Init (0.0f, Num);
+	SlideVelocityZ.Init (0.0f, Num);
+	SlideVelocityX.Reserve (Num);
+	SlideReductionScratch.Reserve (Num);
+	SliderIndices.Reserve (Num);
+
+	Instances->ClearInstances ();
+	for (int32 Runner = 0; Runner < Num; Runner++) {
+		Instances->AddInstanceWorldSpace (FTransform (FVector (PosX[Runner], PosY[Runner], PosZ[Runner])));
+	}
+}
+
+void APlatformerCrowd::SetNumRunners (int32 InNumRunners) {
+	NumRunners = InNumRunners;
+	if (HasActorBegunPlay () && GetNetMode () != NM_DedicatedServer) {
+		ResetRunners ();
+	}
+}
+
+void APlatformerCrowd::Tick (float DeltaSeconds) {
+	Super::Tick (DeltaSeconds);
+
+	PLATFORMER_SCOPE_CYCLE_COUNTER (CrowdTick);
+
+	if (DeltaSeconds <= 0.0f || PosX.Num () == 0) {
+		return;
+	}
+
+	UpdateRunners (DeltaSeconds);
+	UpdateSliders (DeltaSeconds);
+	UpdateInstances ();
+}
+
+void APlatformerCrowd::UpdateRunners (float DeltaTime) {
+	const float CourseStartX = GetActorLocation ().X;
+	const float CourseEndX = CourseStartX + CourseLength;
+	const float SlideStartChance = SlideChance * DeltaTime;
+
+	for (int32 Runner = 0; Runner < PosX.Num (); Runner++) {
+		StateTime[Runner] += DeltaTime;
+
+		switch (State[Runner]) {
+			case EPlatformerCrowdState::Run:
+				Speed[Runner] = FMath::Min (Speed[Runner] + RunAcceleration * DeltaTime, RunSpeed);
+
+				// same speed requirement as PhysWalking
+				if (Speed[Runner] > MinSlideSpeed * 2.0f && Random.FRand () < SlideStartChance) {
+					SlideReduction[Runner] = 0.0f;
+					SetState (Runner, EPlatformerCrowdState::Slide);
+				}
+				break;
+
+			case EPlatformerCrowdState::Slide:
+				// speed is updated by slide batch
+				break;
+
+			case EPlatformerCrowdState::Vault: {
+				const float Alpha = FMath::Min (StateTime[Runner] / VaultDuration[Runner], 1.0f);
+				PosX[Runner] = FMath::Lerp (VaultStartX[Runner], VaultEndX[Runner], Alpha);
+				// up during first half of climb, over during second
+				PosZ[Runner] = FMath::Lerp (VaultStartZ[Runner], VaultEndZ[Runner], FMath::Min (Alpha * 2.0f, 1.0f));
+
+				if (Alpha >= 1.0f) {
+					FloorZ[Runner] = VaultEndZ[Runner];
+					SetState (Runner, EPlatformerCrowdState::Run);
+				}
+				continue;
+			}
+
+			case EPlatformerCrowdState::Fall:
+				VelZ[Runner] += GravityZ * DeltaTime;
+				PosX[Runner] += Speed[Runner] * DeltaTime;
+				PosZ[Runner] += VelZ[Runner] * DeltaTime;
+
+				if (PosZ[Runner] <= GroundZ) {
+					PosZ[Runner] = GroundZ;
+					FloorZ[Runner] = GroundZ;
+					FloorEndX[Runner] = MAX_flt;
+					VelZ[Runner] = 0.0f;
+					SetState (Runner, EPlatformerCrowdState::Run);
+				}
+				continue;
+		}
+
+		// running or sliding
+		PosX[Runner] += Speed[Runner] * DeltaTime;
+
+		if (PosX[Runner] > CourseEndX) {
+			PosX[Runner] = CourseStartX;
+			PosZ[Runner] = FloorZ[Runner] = GroundZ;
+			FloorEndX[Runner] = MAX_flt;
+			SetState (Runner, EPlatformerCrowdState::Run);
+		} else if (PosX[Runner] > FloorEndX[Runner]) {
+			// ran off obstacle top
+			VelZ[Runner] = 0.0f;
+			SetState (Runner, EPlatformerCrowdState::Fall);
+		} else {
+			TryStartVault (Runner, DeltaTime);
+		}
+	}
+}
+
+bool APlatformerCrowd::TryStartVault (int32 Runner, float DeltaTime) {
+	if (!ObstacleIndex.IsValid ()) {
+		return false;
+	}
+
+	// probe just in front of capsule, as high as ClimbOverObstacle traces from ; ignore anything pawn would step over
+	const FVector Probe (PosX[Runner] + Radius + Speed[Runner] * DeltaTime, PosY[Runner], 0.0f);
+	const float MinZ = FloorZ[Runner] + StepHeight;
+	const float MaxZ = FloorZ[Runner] + HalfHeight * 2.0f + 150.0f;
+
+	FPlatformerObstacleTop Top;
+	if (!ObstacleIndex->FindObstacleTop (Probe, MinZ, MaxZ, Top)) {
+		return false;
+	}
+
+	const EPlatformerObstacleClass Class = RunnerDefaults->ClassifyObstacleHeight (Top.TopZ - FloorZ[Runner]);
+	const float Duration = ClimbDurations[(int32)Class];
+
+	// fast runners would have found obstacle by look-ahead sweep and keep their speed
+	Speed[Runner] *= (Speed[Runner] > LookAheadMinSpeed) ? LookAheadVaultSpeedScale : ObstacleHitSpeedScale;
+
+	VaultClass[Runner] = (uint8)Class;
+	VaultDuration[Runner] = (Duration > 0.0f) ? Duration : DefaultClimbDuration;
+	VaultStartX[Runner] = PosX[Runner];
+	VaultStartZ[Runner] = PosZ[Runner];
+	VaultEndX[Runner] = FMath::Max (Top.Min.X + Radius, PosX[Runner]);
+	VaultEndZ[Runner] = Top.TopZ;
+	FloorEndX[Runner] = Top.Max.X;
+	SetState (Runner, EPlatformerCrowdState::Vault);
+	return true;
+}
+
+void APlatformerCrowd::UpdateSliders (float DeltaTime) {
+	SliderIndices.Reset ();
+	SlideVelocityX.Reset ();
+	SlideReductionScratch.Reset ();
+
+	for (int32 Runner = 0; Runner < State.Num (); Runner++) {
+		if (State[Runner] == EPlatformerCrowdState::Slide) {
+			SliderIndices.Add (Runner);
+			SlideVelocityX.Add (Speed[Runner]);
+			SlideReductionScratch.Add (SlideReduction[Runner]);
+		}
+	}
+
+	if (SliderIndices.Num () == 0) {
+		return;
+	}
+
+	// Y and Z of velocity stay zero for sliders running along X
+	FPlatformerSlideBatch Batch;
+	Batch.VelocityX = SlideVelocityX.GetData ();
+	Batch.VelocityY = SlideVelocityY.GetData ();
+	Batch.VelocityZ = SlideVelocityZ.GetData ();
+	Batch.FloorNormalX = SlideFloorNormalX.GetData ();
+	Batch.FloorNormalY = SlideFloorNormalY.GetData ();
+	Batch.FloorNormalZ = SlideFloorNormalZ.GetData ();
+	Batch.Reduction = SlideReductionScratch.GetData ();
+	Batch.ReductionRate = SlideReductionRates.GetData ();
+	// movement accelerates downhill at reduction rate unless floor material scales it ; crowd floor is flat
+	Batch.AccelerationRate = SlideReductionRates.GetData ();
+	Batch.MinSpeed = SlideMinSpeeds.GetData ();
+	Batch.MaxSpeed = SlideMaxSpeeds.GetData ();
+	Batch.Num = SliderIndices.Num ();
+	FPlatformerSlideKernel::StepBatch (Batch, DeltaTime);
+
+	for (int32 Slider = 0; Slider < SliderIndices.Num (); Slider++) {
+		const int32 Runner = SliderIndices[Slider];
+		Speed[Runner] = SlideVelocityX[Slider];
+		SlideReduction[Runner] = SlideReductionScratch[Slider];
+
+		// slide has min speed, as in PhysWalking
+		if (Speed[Runner] <= MinSlideSpeed) {
+			SetState (Runner, EPlatformerCrowdState::Run);
+		}
+	}
+}
+
+void APlatformerCrowd::UpdateInstances () {
+	const float InvNumFrames = 1.0f / FMath::Max (NumAnimationFrames, 1);
+	const FTransform ComponentTransform = Instances->GetComponentTransform ();
+
+	// every runner moves every frame: instance data is written in one pass, bounds and render data are updated once
+	TArray<FInstancedStaticMeshInstanceData>& InstanceData = Instances->PerInstanceSMData;
+	check (InstanceData.Num () == PosX.Num ());
+
+	for (int32 Runner = 0; Runner < PosX.Num (); Runner++) {
+		const FPlatformerCrowdClip& Clip = GetClip (Runner);
+		const int32 NumClipFrames = FMath::Max (Clip.NumFrames, 1);
+		const int32 ClipFrame = FMath::FloorToInt (StateTime[Runner] * AnimationFrameRate);
+		const int32 Frame = Clip.FirstFrame + (Clip.bLoop ? ClipFrame % NumClipFrames : FMath::Min (ClipFrame, NumClipFrames - 1));
+
+		const FVector Scale (1.0f + PlatformerCrowd::FrameScaleEncoding * Frame * InvNumFrames, 1.0f, 1.0f);
+		const FTransform InstanceTransform (FQuat::Identity, FVector (PosX[Runner], PosY[Runner], PosZ[Runner]), Scale);
+		InstanceData[Runner].Transform = InstanceTransform.GetRelativeTransform (ComponentTransform).ToMatrixWithScale ();
+	}
+
+	Instances->UpdateBounds ();
+	Instances->MarkRenderStateDirty ();
+}
+
+void APlatformerCrowd::SetState (int32 Runner, EPlatformerCrowdState::Type NewState) {
+	State[Runner] = NewState;
+	StateTime[Runner] = 0.0f;
+}
+
+const FPlatformerCrowdClip& APlatformerCrowd::GetClip (int32 Runner) const {
+	switch (State[Runner]) {
+		case EPlatformerCrowdState::Slide:
+			return SlideClip;
+
+		case EPlatformerCrowdState::Fall:
+			return FallClip;
+
+		case EPlatformerCrowdState::Vault:
+			return (VaultClass[Runner] == (uint8)EPlatformerObstacleClass::Small) ? ClimbOverSmallClip :
+				(VaultClass[Runner] == (uint8)EPlatformerObstacleClass::Mid) ? ClimbOverMidClip :
+				ClimbOverBigClip;
+
+		default:
+			return RunClip;
+	}
+}
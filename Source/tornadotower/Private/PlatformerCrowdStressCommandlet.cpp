@@ -0,0 +1,320 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "tornadotower.h"
+#include "../Public/PlatformerCrowdStressCommandlet.h"
+#include "../Public/PlatformerCharacter.h"
+#include "../Public/PlatformerPlayerMovementComp.h"
+#include "../Public/PlatformerSignificanceManager.h"
+#include "../Public/PlatformerCrowd.h"
+#include "../Public/PlatformerPerfCounters.h"
+#include "../Public/PlatformerTestLevel.h"
+#include "Json.h"
+
+DEFINE_LOG_CATEGORY_STATIC (LogPlatformerCrowdStress, Log, All);
+
+namespace PlatformerCrowdStress {
+
+/** course layout, kept clear of default test level geometry at |Y| < 2000 */
+static const float CourseStartX = -9000.0f;
+static const float CourseEndX = 9000.0f;
+static const float CourseMinY = 2500.0f;
+static const float ObstacleSpacing = 600.0f;
+static const float LaneWidth = 150.0f;
+static const int32 MaxLanes = 50;
+
+/** offset from start of course section to spawn point, behind any obstacle of the section */
+static const float SpawnOffsetX = 400.0f;
+
+static const float DeltaTime = 1.0f / 60.0f;
+static const int32 WarmupFrames = 60;
+
+/** chance per frame that idle runner starts sliding or jumps */
+static const float SlideChance = 0.01f;
+static const float JumpChance = 0.01f;
+
+struct FRunner {
+	APlatformerCharacter* Character;
+	float SlideTimeLeft;
+	bool bWasVaulting;
+	bool bWasSliding;
+};
+
+/** frame time samples of one crowd size, in ms */
+struct FFrameSamples {
+	TArray<float> Total;
+	TArray<float> Movement;
+	TArray<float> Animation;
+	TArray<float> Collision;
+};
+
+static TSharedRef<FJsonObject> MakePercentilesObject (TArray<float>& Samples) {
+	Samples.Sort ();
+
+	TSharedRef<FJsonObject> Object = MakeShareable (new FJsonObject ());
+	Object->SetNumberField (TEXT ("P50"), FPlatformerPerfCounters::GetPercentile (Samples, 0.5f));
+	Object->SetNumberField (TEXT ("P95"), FPlatformerPerfCounters::GetPercentile (Samples, 0.95f));
+	Object->SetNumberField (TEXT ("P99"), FPlatformerPerfCounters::GetPercentile (Samples, 0.99f));
+	Object->SetNumberField (TEXT ("Max"), Samples.Num () > 0 ? Samples.Last () : 0.0f);
+	return Object;
+}
+
+static void LogPercentiles (const TCHAR* Name, const TArray<float>& Sorted) {
+	UE_LOG (LogPlatformerCrowdStress, Display, TEXT ("  %-10s p50 %8.3f ms  p95 %8.3f ms  p99 %8.3f ms"), Name,
+		FPlatformerPerfCounters::GetPercentile (Sorted, 0.5f), FPlatformerPerfCounters::GetPercentile (Sorted, 0.95f), FPlatformerPerfCounters::GetPercentile (Sorted, 0.99f));
+}
+
+/** runs one crowd size in fresh level ; returns NULL if level couldn't be set up */
+static TSharedPtr<FJsonObject> RunCrowd (UClass* CharacterClass, int32 NumRunners, int32 NumFrames, bool bSignificance, bool bBatch) {
+	FPlatformerTestLevel Level;
+	if (!Level.Create ()) {
+		UE_LOG (LogPlatformerCrowdStress, Error, TEXT ("Failed to create test level"));
+		return NULL;
+	}
+
+	const int32 NumLanes = FMath::Min (NumRunners, MaxLanes);
+	const int32 RunnersPerLane = FMath::DivideAndRoundUp (NumRunners, NumLanes);
+	const int32 NumSections = FMath::FloorToInt ((CourseEndX - CourseStartX) / ObstacleSpacing);
+	Level.SpawnObstacleCourse (CourseStartX, CourseEndX, CourseMinY, CourseMinY + NumLanes * LaneWidth, ObstacleSpacing, NumRunners);
+
+	FRandomStream Random (NumRunners);
+	TArray<FRunner> Runners;
+	Runners.Reserve (NumRunners);
+	for (int32 Idx = 0; Idx < NumRunners; Idx++) {
+		const int32 Lane = Idx % NumLanes;
+		const int32 Section = (Idx / NumLanes) * NumSections / RunnersPerLane;
+		const float X = CourseStartX + Section * ObstacleSpacing + SpawnOffsetX;
+		const float Y = CourseMinY + (Lane + 0.5f) * LaneWidth;
+
+		APlatformerCharacter* Character = Level.SpawnCharacter (CharacterClass, X, Y);
+		if (!Character) {
+			UE_LOG (LogPlatformerCrowdStress, Error, TEXT ("Failed to spawn runner %d"), Idx);
+			return NULL;
+		}
+
+		if (!bSignificance) {
+			APlatformerSignificanceManager* Manager = APlatformerSignificanceManager::Get (Level.GetWorld ());
+			if (Manager) {
+				Manager->UnregisterCharacter (Character);
+			}
+			CastChecked<UPlatformerPlayerMovementComp> (Character->GetCharacterMovement ())->SetMovementLODEnabled (false);
+		}
+
+		if (bBatch) {
+			CastChecked<UPlatformerPlayerMovementComp> (Character->GetCharacterMovement ())->SetUseBatchMovement (true);
+		}
+
+		// animation is ticked by hand to time it separately
+		Character->GetMesh ()->SetComponentTickEnabled (false);
+
+		FRunner Runner;
+		Runner.Character = Character;
+		Runner.SlideTimeLeft = 0.0f;
+		Runner.bWasVaulting = false;
+		Runner.bWasSliding = false;
+		Runners.Add (Runner);
+	}
+
+	FFrameSamples Samples;
+	int32 NumClimbs = 0;
+	int32 NumSlides = 0;
+
+	FPlatformerPerfCounters::bEnabled = true;
+	for (int32 Frame = 0; Frame < WarmupFrames + NumFrames; Frame++) {
+		for (FRunner& Runner : Runners) {
+			APlatformerCharacter* Character = Runner.Character;
+			UPlatformerPlayerMovementComp* MoveComp = CastChecked<UPlatformerPlayerMovementComp> (Character->GetCharacterMovement ());
+
+			// back to start at the end of course
+			if (MoveComp->MovementMode == MOVE_Walking && Character->GetActorLocation ().X > CourseEndX - ObstacleSpacing) {
+				const FVector Location = Character->GetActorLocation ();
+				Character->TeleportTo (FVector (CourseStartX + SpawnOffsetX, Location.Y, Location.Z), FRotator::ZeroRotator, false, true);
+			}
+
+			Character->AddMovementInput (FVector::ForwardVector, 1.0f);
+
+			if (Runner.SlideTimeLeft > 0.0f) {
+				Runner.SlideTimeLeft -= DeltaTime;
+				if (Runner.SlideTimeLeft <= 0.0f) {
+					Character->SetWantsToSlide (false);
+				}
+			} else if (Random.FRand () < SlideChance) {
+				Character->SetWantsToSlide (true);
+				Runner.SlideTimeLeft = Random.FRandRange (0.3f, 1.0f);
+			} else if (Random.FRand () < JumpChance) {
+				Character->Jump ();
+			} else {
+				Character->StopJumping ();
+			}
+
+			if (MoveComp->IsVaulting () && !Runner.bWasVaulting) {
+				NumClimbs++;
+			}
+			if (Character->IsSliding () && !Runner.bWasSliding) {
+				NumSlides++;
+			}
+			Runner.bWasVaulting = MoveComp->IsVaulting ();
+			Runner.bWasSliding = Character->IsSliding ();
+		}
+
+		FPlatformerPerfCounters::Reset ();
+
+		const uint32 WorldStartCycles = FPlatformTime::Cycles ();
+		Level.Tick (DeltaTime);
+		const uint32 WorldCycles = FPlatformTime::Cycles () - WorldStartCycles;
+
+		const uint32 AnimStartCycles = FPlatformTime::Cycles ();
+		for (FRunner& Runner : Runners) {
+			Runner.Character->GetMesh ()->TickComponent (DeltaTime, LEVELTICK_All, NULL);
+		}
+		const uint32 AnimCycles = FPlatformTime::Cycles () - AnimStartCycles;
+
+		if (Frame >= WarmupFrames) {
+			Samples.Total.Add (FPlatformTime::ToMilliseconds (WorldCycles + AnimCycles));
+			Samples.Movement.Add (FPlatformTime::ToMilliseconds (FPlatformerPerfCounters::Cycles[EPlatformerCycleCounter::MovementTick] + FPlatformerPerfCounters::Cycles[EPlatformerCycleCounter::BatchMovement]));
+			Samples.Animation.Add (FPlatformTime::ToMilliseconds (AnimCycles));
+			Samples.Collision.Add (FPlatformTime::ToMilliseconds (FPlatformerPerfCounters::Cycles[EPlatformerCycleCounter::CollisionQuery]));
+		}
+	}
+	FPlatformerPerfCounters::bEnabled = false;
+
+	Level.Destroy ();
+
+	TSharedRef<FJsonObject> Result = MakeShareable (new FJsonObject ());
+	Result->SetNumberField (TEXT ("Runners"), NumRunners);
+	Result->SetNumberField (TEXT ("Climbs"), NumClimbs);
+	Result->SetNumberField (TEXT ("Slides"), NumSlides);
+	Result->SetObjectField (TEXT ("Total"), MakePercentilesObject (Samples.Total));
+	Result->SetObjectField (TEXT ("Movement"), MakePercentilesObject (Samples.Movement));
+	Result->SetObjectField (TEXT ("Animation"), MakePercentilesObject (Samples.Animation));
+	Result->SetObjectField (TEXT ("Collision"), MakePercentilesObject (Samples.Collision));
+
+	UE_LOG (LogPlatformerCrowdStress, Display, TEXT ("%d runners, %d climbs, %d slides:"), NumRunners, NumClimbs, NumSlides);
+	LogPercentiles (TEXT ("Total"), Samples.Total);
+	LogPercentiles (TEXT ("Movement"), Samples.Movement);
+	LogPercentiles (TEXT ("Animation"), Samples.Animation);
+	LogPercentiles (TEXT ("Collision"), Samples.Collision);
+
+	return Result;
+}
+
+/** runs one crowd size as APlatformerCrowd in fresh level ; returns NULL if level couldn't be set up */
+static TSharedPtr<FJsonObject> RunCrowdActor (int32 NumRunners, int32 NumFrames) {
+	FPlatformerTestLevel Level;
+	if (!Level.Create ()) {
+		UE_LOG (LogPlatformerCrowdStress, Error, TEXT ("Failed to create test level"));
+		return NULL;
+	}
+
+	// test level has no baked obstacle index, runners run, slide and fall but don't vault
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	APlatformerCrowd* Crowd = Level.GetWorld ()->SpawnActor<APlatformerCrowd> (FVector (CourseStartX, CourseMinY, 0.0f), FRotator::ZeroRotator, SpawnParams);
+	if (!Crowd) {
+		UE_LOG (LogPlatformerCrowdStress, Error, TEXT ("Failed to spawn crowd"));
+		return NULL;
+	}
+	Crowd->SetNumRunners (NumRunners);
+
+	TArray<float> TotalSamples;
+	TArray<float> CrowdSamples;
+
+	FPlatformerPerfCounters::bEnabled = true;
+	for (int32 Frame = 0; Frame < WarmupFrames + NumFrames; Frame++) {
+		FPlatformerPerfCounters::Reset ();
+
+		const uint32 WorldStartCycles = FPlatformTime::Cycles ();
+		Level.Tick (DeltaTime);
+		const uint32 WorldCycles = FPlatformTime::Cycles () - WorldStartCycles;
+
+		if (Frame >= WarmupFrames) {
+			TotalSamples.Add (FPlatformTime::ToMilliseconds (WorldCycles));
+			CrowdSamples.Add (FPlatformTime::ToMilliseconds (FPlatformerPerfCounters::Cycles[EPlatformerCycleCounter::CrowdTick]));
+		}
+	}
+	FPlatformerPerfCounters::bEnabled = false;
+
+	Level.Destroy ();
+
+	TSharedRef<FJsonObject> Result = MakeShareable (new FJsonObject ());
+	Result->SetNumberField (TEXT ("Runners"), NumRunners);
+	Result->SetObjectField (TEXT ("Total"), MakePercentilesObject (TotalSamples));
+	Result->SetObjectField (TEXT ("Crowd"), MakePercentilesObject (CrowdSamples));
+
+	UE_LOG (LogPlatformerCrowdStress, Display, TEXT ("%d crowd runners:"), NumRunners);
+	LogPercentiles (TEXT ("Total"), TotalSamples);
+	LogPercentiles (TEXT ("Crowd"), CrowdSamples);
+
+	return Result;
+}
+
+}
+
+UPlatformerCrowdStressCommandlet::UPlatformerCrowdStressCommandlet (const FObjectInitializer& ObjectInitializer)
+	: Super (ObjectInitializer) {
+	IsClient = false;
+	IsEditor = false;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UPlatformerCrowdStressCommandlet::Main (const FString& Params) {
+	using namespace PlatformerCrowdStress;
+
+	FString RunnersList = TEXT ("10,50,100,250,500,1000");
+	FParse::Value (*Params, TEXT ("Runners="), RunnersList, false);
+
+	int32 NumFrames = 600;
+	FParse::Value (*Params, TEXT ("Frames="), NumFrames);
+	NumFrames = FMath::Max (NumFrames, 1);
+
+	const bool bSignificance = FParse::Param (*Params, TEXT ("Significance"));
+	const bool bBatch = FParse::Param (*Params, TEXT ("Batch"));
+	const bool bCrowd = FParse::Param (*Params, TEXT ("Crowd"));
+
+	FString OutputFile = FPaths::GameSavedDir () / TEXT ("Benchmarks") / TEXT ("PlatformerCrowdStress.json");
+	FParse::Value (*Params, TEXT ("Output="), OutputFile);
+
+	FString CharacterClassName = TEXT ("/Game/ThirdPersonCPP/Blueprints/PlatformerCharacter.PlatformerCharacter_C");
+	FParse::Value (*Params, TEXT ("Character="), CharacterClassName);
+
+	UClass* CharacterClass = LoadClass<APlatformerCharacter> (NULL, *CharacterClassName);
+	if (!CharacterClass) {
+		UE_LOG (LogPlatformerCrowdStress, Warning, TEXT ("Failed to load character class %s, running without mesh and animations"), *CharacterClassName);
+		CharacterClass = APlatformerCharacter::StaticClass ();
+	}
+
+	TArray<FString> RunnerCounts;
+	RunnersList.ParseIntoArray (RunnerCounts, TEXT (","), true);
+
+	TArray<TSharedPtr<FJsonValue>> Results;
+	for (const FString& Count : RunnerCounts) {
+		const int32 NumRunners = FMath::Clamp (FCString::Atoi (*Count), 10, 1000);
+
+		TSharedPtr<FJsonObject> Result = bCrowd ? RunCrowdActor (NumRunners, NumFrames) : RunCrowd (CharacterClass, NumRunners, NumFrames, bSignificance, bBatch);
+		if (!Result.IsValid ()) {
+			return 1;
+		}
+		Results.Add (MakeShareable (new FJsonValueObject (Result)));
+
+		CollectGarbage (GARBAGE_COLLECTION_KEEPFLAGS);
+	}
+
+	TSharedRef<FJsonObject> Root = MakeShareable (new FJsonObject ());
+	Root->SetNumberField (TEXT ("Frames"), NumFrames);
+	Root->SetStringField (TEXT ("Character"), CharacterClass->GetPathName ());
+	Root->SetBoolField (TEXT ("Significance"), bSignificance);
+	Root->SetBoolField (TEXT ("Batch"), bBatch);
+	Root->SetBoolField (TEXT ("Crowd"), bCrowd);
+	Root->SetArrayField (TEXT ("Results"), Results);
+
+	FString Output;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create (&Output);
+	FJsonSerializer::Serialize (Root, Writer);
+	if (!FFileHelper::SaveStringToFile (Output, *OutputFile)) {
+		UE_LOG (LogPlatformerCrowdStress, Error, TEXT ("Failed to write results to %s"), *OutputFile);
+		return 1;
+	}
+	UE_LOG (LogPlatformerCrowdStress, Display, TEXT ("Results written to %s"), *OutputFile);
+
+	return 0;
+}
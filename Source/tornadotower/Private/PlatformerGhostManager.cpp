@@ -0,0 +1,206 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "tornadotower.h"
+#include "../Public/PlatformerGhostManager.h"
+#include "../Public/PlatformerCharacter.h"
+
+DEFINE_LOG_CATEGORY_STATIC (LogPlatformerGhostManager, Log, All);
+
+/** transform of instances of poses ghost isn't in */
+static const FTransform HiddenInstanceTransform (FQuat::Identity, FVector::ZeroVector, FVector::ZeroVector);
+
+APlatformerGhostManager::APlatformerGhostManager (const FObjectInitializer& ObjectInitializer)
+	: Super (ObjectInitializer) {
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
+
+	MaxGhosts = 32;
+	SampleRate = 30.0f;
+	KeyframeInterval = 64;
+
+	RunTime = 0.0f;
+	NextSampleTime = 0.0f;
+	bPlaying = false;
+	bReloadGhosts = false;
+	bPoseMeshesLoaded = false;
+}
+
+APlatformerGhostManager* APlatformerGhostManager::Get (UWorld* World) {
+	if (!World || !World->IsGameWorld () || World->GetNetMode () == NM_DedicatedServer) {
+		return nullptr;
+	}
+
+	for (TActorIterator<APlatformerGhostManager> It (World); It; ++It) {
+		return *It;
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	return World->SpawnActor<APlatformerGhostManager> (SpawnParams);
+}
+
+void APlatformerGhostManager::PostInitializeComponents () {
+	Super::PostInitializeComponents ();
+
+	const FStringAssetReference* PoseMeshes[EPlatformerGhostPose::Num] = { &RunMesh, &SlideMesh, &VaultMesh, &FallMesh };
+	PoseInstances.SetNum (EPlatformerGhostPose::Num);
+	bPoseMeshesLoaded = true;
+	for (int32 Pose = 0; Pose < EPlatformerGhostPose::Num; Pose++) {
+		UStaticMesh* Mesh = Cast<UStaticMesh> (PoseMeshes[Pose]->TryLoad ());
+		if (!Mesh) {
+			UE_LOG (LogPlatformerGhostManager, Warning, TEXT ("Ghost pose mesh '%s' couldn't be loaded, ghosts won't be played"), *PoseMeshes[Pose]->ToString ());
+			bPoseMeshesLoaded = false;
+		}
+
+		UInstancedStaticMeshComponent* Instances = NewObject<UInstancedStaticMeshComponent> (this);
+		Instances->SetMobility (EComponentMobility::Movable);
+		Instances->SetCollisionEnabled (ECollisionEnabled::NoCollision);
+		Instances->SetCastShadow (false);
+		Instances->SetStaticMesh (Mesh);
+		Instances->RegisterComponent ();
+		PoseInstances[Pose] = Instances;
+	}
+
+	LoadGhosts ();
+}
+
+FString APlatformerGhostManager::GetGhostDirectory () const {
+	return FPaths::GameSavedDir () / TEXT ("Ghosts") / UWorld::RemovePIEPrefix (GetWorld ()->GetMapName ());
+}
+
+void APlatformerGhostManager::LoadGhosts () {
+	Tracks.Reset ();
+	Cursors.Reset ();
+	GhostPoses.Reset ();
+
+	// file names start with zero padded run time, so fastest runs come first
+	const FString Directory = GetGhostDirectory ();
+	TArray<FString> Filenames;
+	IFileManager::Get ().FindFiles (Filenames, *(Directory / TEXT ("*.ghost")), true, false);
+	Filenames.Sort ();
+
+	int32 NumMapped = 0;
+	for (const FString& Filename : Filenames) {
+		if (Tracks.Num () >= MaxGhosts) {
+			break;
+		}
+
+		TUniquePtr<FPlatformerGhostTrack> Track = MakeUnique<FPlatformerGhostTrack> ();
+		if (Track->Open (Directory / Filename)) {
+			NumMapped += Track->IsMapped () ? 1 : 0;
+			Tracks.Add (MoveTemp (Track));
+		}
+	}
+
+	Cursors.SetNum (Tracks.Num ());
+	GhostPoses.Init (EPlatformerGhostPose::Run, Tracks.Num ());
+	for (int32 GhostIdx = 0; GhostIdx < Tracks.Num (); GhostIdx++) {
+		Cursors[GhostIdx].Reset (Tracks[GhostIdx].Get ());
+	}
+
+	for (UInstancedStaticMeshComponent* Instances : PoseInstances) {
+		Instances->ClearInstances ();
+		for (int32 GhostIdx = 0; GhostIdx < Tracks.Num (); GhostIdx++) {
+			Instances->AddInstanceWorldSpace (HiddenInstanceTransform);
+		}
+	}
+
+	UE_LOG (LogPlatformerGhostManager, Log, TEXT ("Loaded %d ghosts from %s (%d memory mapped)"), Tracks.Num (), *Directory, NumMapped);
+}
+
+void APlatformerGhostManager::StartRun (APlatformerCharacter* Character) {
+	if (bReloadGhosts) {
+		bReloadGhosts = false;
+		LoadGhosts ();
+	}
+
+	RunTime = 0.0f;
+	NextSampleTime = 0.0f;
+	bPlaying = bPoseMeshesLoaded && Tracks.Num () > 0;
+
+	RecordedCharacter = Character;
+	Recording.Reset ();
+	if (Character) {
+		Recording = MakeUnique<FPlatformerGhostWriter> (1.0f / FMath::Max (SampleRate, 1.0f), (uint16)FMath::Clamp (KeyframeInterval, 1, (int32)MAX_uint16));
+	}
+
+	UpdateGhosts ();
+	UpdateTickEnabled ();
+}
+
+void APlatformerGhostManager::FinishRun (bool bSave) {
+	if (Recording.IsValid () && bSave && Recording->GetNumSamples () > 0) {
+		const int32 RunTimeMs = FMath::RoundToInt (RunTime * 1000.0f);
+		const FString Filename = GetGhostDirectory () / FString::Printf (TEXT ("%09d_%s.ghost"), RunTimeMs, *FDateTime::Now ().ToString ());
+		if (Recording->SaveToFile (Filename)) {
+			UE_LOG (LogPlatformerGhostManager, Log, TEXT ("Saved ghost %s, %d samples"), *Filename, Recording->GetNumSamples ());
+			bReloadGhosts = true;
+		}
+	}
+
+	Recording.Reset ();
+	RecordedCharacter.Reset ();
+	UpdateTickEnabled ();
+}
+
+void APlatformerGhostManager::Tick (float DeltaSeconds) {
+	Super::Tick (DeltaSeconds);
+
+	RunTime += DeltaSeconds;
+
+	if (Recording.IsValid ()) {
+		const APlatformerCharacter* Character = RecordedCharacter.Get ();
+		if (Character) {
+			while (NextSampleTime <= RunTime) {
+				Recording->AddSample (Character);
+				NextSampleTime += Recording->GetSampleInterval ();
+			}
+		} else {
+			FinishRun (false);
+		}
+	}
+
+	if (bPlaying) {
+		UpdateGhosts ();
+	}
+}
+
+void APlatformerGhostManager::UpdateGhosts () {
+	bool bPoseChanged[EPlatformerGhostPose::Num] = { false };
+	bool bAnyMoving = false;
+
+	for (int32 GhostIdx = 0; GhostIdx < Tracks.Num (); GhostIdx++) {
+		FVector Location;
+		float Yaw;
+		EPlatformerGhostPose::Type Pose;
+		Cursors[GhostIdx].Evaluate (RunTime, Location, Yaw, Pose);
+		bAnyMoving |= (RunTime < Tracks[GhostIdx]->GetDuration ());
+
+		// only instance of old pose is hidden on pose change, others stay hidden
+		const EPlatformerGhostPose::Type OldPose = GhostPoses[GhostIdx];
+		if (OldPose != Pose) {
+			PoseInstances[OldPose]->UpdateInstanceTransform (GhostIdx, HiddenInstanceTransform, true, false);
+			bPoseChanged[OldPose] = true;
+			GhostPoses[GhostIdx] = Pose;
+		}
+
+		PoseInstances[Pose]->UpdateInstanceTransform (GhostIdx, FTransform (FRotator (0.0f, Yaw, 0.0f), Location), true, false);
+		bPoseChanged[Pose] = true;
+	}
+
+	for (int32 Pose = 0; Pose < EPlatformerGhostPose::Num; Pose++) {
+		if (bPoseChanged[Pose]) {
+			PoseInstances[Pose]->MarkRenderStateDirty ();
+		}
+	}
+
+	// all ghosts reached their end
+	if (!bAnyMoving) {
+		bPlaying = false;
+		UpdateTickEnabled ();
+	}
+}
+
+void APlatformerGhostManager::UpdateTickEnabled () {
+	SetActorTickEnabled (bPlaying || Recording.IsValid ());
+}
@@ -0,0 +1,288 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "tornadotower.h"
+#include "../Public/PlatformerGhostTrack.h"
+#include "../Public/PlatformerCharacter.h"
+#include "../Public/PlatformerPlayerMovementComp.h"
+
+#if PLATFORM_WINDOWS
+#include "AllowWindowsPlatformTypes.h"
+#include <windows.h>
+#include "HideWindowsPlatformTypes.h"
+#elif PLATFORM_LINUX || PLATFORM_MAC
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+DEFINE_LOG_CATEGORY_STATIC (LogPlatformerGhost, Log, All);
+
+FPlatformerGhostWriter::FPlatformerGhostWriter (float InSampleInterval, uint16 InKeyframeInterval)
+	: SampleInterval (InSampleInterval)
+	, KeyframeInterval (FMath::Max<uint16> (InKeyframeInterval, 1))
+	, LastPosition (0, 0, 0) {
+}
+
+void FPlatformerGhostWriter::AddSample (const FVector& Location, float Yaw, EPlatformerGhostPose::Type Pose) {
+	const FIntVector Quantized (
+		FMath::RoundToInt (Location.X * PlatformerGhost::PositionScale),
+		FMath::RoundToInt (Location.Y * PlatformerGhost::PositionScale),
+		FMath::RoundToInt (Location.Z * PlatformerGhost::PositionScale));
+
+	FPlatformerGhostSample Sample;
+	Sample.Yaw = PlatformerGhost::QuantizeYaw (Yaw);
+	Sample.Pose = (uint8)Pose;
+
+	if (Samples.Num () % KeyframeInterval == 0) {
+		FPlatformerGhostKeyframe Keyframe;
+		Keyframe.X = Quantized.X;
+		Keyframe.Y = Quantized.Y;
+		Keyframe.Z = Quantized.Z;
+		Keyframes.Add (Keyframe);
+
+		Sample.DeltaX = Sample.DeltaY = Sample.DeltaZ = 0;
+		LastPosition = Quantized;
+	} else {
+		// teleports don't fit into a delta, playback catches up at next keyframe
+		Sample.DeltaX = (int16)FMath::Clamp (Quantized.X - LastPosition.X, (int32)MIN_int16, (int32)MAX_int16);
+		Sample.DeltaY = (int16)FMath::Clamp (Quantized.Y - LastPosition.Y, (int32)MIN_int16, (int32)MAX_int16);
+		Sample.DeltaZ = (int16)FMath::Clamp (Quantized.Z - LastPosition.Z, (int32)MIN_int16, (int32)MAX_int16);
+		LastPosition += FIntVector (Sample.DeltaX, Sample.DeltaY, Sample.DeltaZ);
+	}
+
+	Samples.Add (Sample);
+}
+
+void FPlatformerGhostWriter::AddSample (const APlatformerCharacter* Character) {
+	AddSample (Character->GetActorLocation (), Character->GetActorRotation ().Yaw, GetPose (Character));
+}
+
+EPlatformerGhostPose::Type FPlatformerGhostWriter::GetPose (const APlatformerCharacter* Character) {
+	const UPlatformerPlayerMovementComp* MoveComp = Cast<UPlatformerPlayerMovementComp> (Character->GetCharacterMovement ());
+	if (!MoveComp) {
+		return EPlatformerGhostPose::Run;
+	}
+
+	if (MoveComp->IsVaulting ()) {
+		return EPlatformerGhostPose::Vault;
+	} else if (MoveComp->IsSliding ()) {
+		return EPlatformerGhostPose::Slide;
+	} else if (MoveComp->IsFalling ()) {
+		return EPlatformerGhostPose::Fall;
+	}
+
+	return EPlatformerGhostPose::Run;
+}
+
+bool FPlatformerGhostWriter::SaveToFile (const FString& Filename) const {
+	TArray<uint8> Data;
+	FMemoryWriter Writer (Data);
+
+	// written field by field in declaration order, matching in-memory layout read back by FPlatformerGhostTrack
+	FPlatformerGhostHeader Header;
+	Header.Magic = PlatformerGhost::FileMagic;
+	Header.Version = PlatformerGhost::FileVersion;
+	Header.KeyframeInterval = KeyframeInterval;
+	Header.SampleInterval = SampleInterval;
+	Header.NumSamples = Samples.Num ();
+	Header.Reserved = 0;
+	Writer << Header.Magic << Header.Version << Header.KeyframeInterval << Header.SampleInterval << Header.NumSamples << Header.Reserved;
+
+	for (FPlatformerGhostKeyframe Keyframe : Keyframes) {
+		Writer << Keyframe.X << Keyframe.Y << Keyframe.Z;
+	}
+
+	for (FPlatformerGhostSample Sample : Samples) {
+		Writer << Sample.DeltaX << Sample.DeltaY << Sample.DeltaZ << Sample.Yaw << Sample.Pose;
+	}
+
+	return FFileHelper::SaveArrayToFile (Data, *Filename);
+}
+
+FPlatformerMappedFile::FPlatformerMappedFile ()
+	: Data (nullptr)
+	, Size (0)
+	, bMapped (false)
+#if PLATFORM_WINDOWS
+	, FileHandle (nullptr)
+	, MappingHandle (nullptr)
+#endif
+{
+}
+
+FPlatformerMappedFile::~FPlatformerMappedFile () {
+	Close ();
+}
+
+bool FPlatformerMappedFile::Open (const FString& Filename) {
+	Close ();
+
+	const FString FullPath = FPaths::ConvertRelativePathToFull (Filename);
+
+#if PLATFORM_WINDOWS
+	HANDLE File = CreateFileW (*FullPath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (File != INVALID_HANDLE_VALUE) {
+		LARGE_INTEGER FileSize;
+		HANDLE Mapping = (GetFileSizeEx (File, &FileSize) && FileSize.QuadPart > 0) ? CreateFileMappingW (File, NULL, PAGE_READONLY, 0, 0, NULL) : NULL;
+		const void* View = Mapping ? MapViewOfFile (Mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+		if (View) {
+			FileHandle = File;
+			MappingHandle = Mapping;
+			Data = (const uint8*)View;
+			Size = FileSize.QuadPart;
+			bMapped = true;
+			return true;
+		}
+
+		if (Mapping) {
+			CloseHandle (Mapping);
+		}
+		CloseHandle (File);
+	}
+#elif PLATFORM_LINUX || PLATFORM_MAC
+	const int File = open (TCHAR_TO_UTF8 (*FullPath), O_RDONLY);
+	if (File >= 0) {
+		struct stat FileStat;
+		void* View = (fstat (File, &FileStat) == 0 && FileStat.st_size > 0) ? mmap (nullptr, FileStat.st_size, PROT_READ, MAP_PRIVATE, File, 0) : MAP_FAILED;
+		// mapping stays valid after descriptor is closed
+		close (File);
+		if (View != MAP_FAILED) {
+			Data = (const uint8*)View;
+			Size = FileStat.st_size;
+			bMapped = true;
+			return true;
+		}
+	}
+#endif
+
+	// no mapping on this platform, or file lives in a pak
+	if (!FFileHelper::LoadFileToArray (Fallback, *Filename)) {
+		return false;
+	}
+
+	Data = Fallback.GetData ();
+	Size = Fallback.Num ();
+	return true;
+}
+
+void FPlatformerMappedFile::Close () {
+	if (bMapped) {
+#if PLATFORM_WINDOWS
+		UnmapViewOfFile (Data);
+		CloseHandle (MappingHandle);
+		CloseHandle (FileHandle);
+		MappingHandle = nullptr;
+		FileHandle = nullptr;
+#elif PLATFORM_LINUX || PLATFORM_MAC
+		munmap (const_cast<uint8*> (Data), Size);
+#endif
+	}
+
+	Fallback.Empty ();
+	Data = nullptr;
+	Size = 0;
+	bMapped = false;
+}
+
+FPlatformerGhostTrack::FPlatformerGhostTrack ()
+	: Header (nullptr)
+	, Keyframes (nullptr)
+	, Samples (nullptr) {
+}
+
+bool FPlatformerGhostTrack::Open (const FString& Filename) {
+	Header = nullptr;
+	Keyframes = nullptr;
+	Samples = nullptr;
+
+	if (!File.Open (Filename) || File.GetSize () < (int64)sizeof (FPlatformerGhostHeader)) {
+		UE_LOG (LogPlatformerGhost, Warning, TEXT ("Can't read ghost %s"), *Filename);
+		return false;
+	}
+
+	const FPlatformerGhostHeader* FileHeader = (const FPlatformerGhostHeader*)File.GetData ();
+	if (FileHeader->Magic != PlatformerGhost::FileMagic || FileHeader->Version != PlatformerGhost::FileVersion ||
+		FileHeader->KeyframeInterval == 0 || FileHeader->NumSamples == 0 || FileHeader->SampleInterval <= 0.0f)
+	{
+		UE_LOG (LogPlatformerGhost, Warning, TEXT ("%s is not a ghost file"), *Filename);
+		return false;
+	}
+
+	const int64 NumKeyframes = (FileHeader->NumSamples + FileHeader->KeyframeInterval - 1) / FileHeader->KeyframeInterval;
+	const int64 ExpectedSize = sizeof (FPlatformerGhostHeader) + NumKeyframes * sizeof (FPlatformerGhostKeyframe) + (int64)FileHeader->NumSamples * sizeof (FPlatformerGhostSample);
+	if (File.GetSize () < ExpectedSize) {
+		UE_LOG (LogPlatformerGhost, Warning, TEXT ("Ghost %s is truncated"), *Filename);
+		return false;
+	}
+
+	Header = FileHeader;
+	Keyframes = (const FPlatformerGhostKeyframe*)(File.GetData () + sizeof (FPlatformerGhostHeader));
+	Samples = (const FPlatformerGhostSample*)(Keyframes + NumKeyframes);
+	return true;
+}
+
+FPlatformerGhostCursor::FPlatformerGhostCursor ()
+	: Track (nullptr)
+	, SampleIndex (0)
+	, Position (0, 0, 0) {
+}
+
+void FPlatformerGhostCursor::Reset (const FPlatformerGhostTrack* InTrack) {
+	Track = InTrack;
+	SampleIndex = 0;
+
+	const FPlatformerGhostKeyframe& Keyframe = Track->GetKeyframe (0);
+	Position = FIntVector (Keyframe.X, Keyframe.Y, Keyframe.Z);
+}
+
+void FPlatformerGhostCursor::Seek (int32 NewSampleIndex) {
+	const int32 KeyframeInterval = Track->GetHeader ()->KeyframeInterval;
+	const int32 KeyframeStart = NewSampleIndex - NewSampleIndex % KeyframeInterval;
+
+	// restart from keyframe when going back or when it's closer than current sample
+	if (NewSampleIndex < SampleIndex || SampleIndex < KeyframeStart) {
+		const FPlatformerGhostKeyframe& Keyframe = Track->GetKeyframe (KeyframeStart);
+		Position = FIntVector (Keyframe.X, Keyframe.Y, Keyframe.Z);
+		SampleIndex = KeyframeStart;
+	}
+
+	while (SampleIndex < NewSampleIndex) {
+		SampleIndex++;
+		const FPlatformerGhostSample& Sample = Track->GetSample (SampleIndex);
+		Position += FIntVector (Sample.DeltaX, Sample.DeltaY, Sample.DeltaZ);
+	}
+}
+
+void FPlatformerGhostCursor::Evaluate (float Time, FVector& OutLocation, float& OutYaw, EPlatformerGhostPose::Type& OutPose) {
+	const FPlatformerGhostHeader* Header = Track->GetHeader ();
+	const int32 LastSample = Header->NumSamples - 1;
+
+	const float SampleTime = FMath::Max (Time, 0.0f) / Header->SampleInterval;
+	const int32 Index = FMath::Min (FMath::FloorToInt (SampleTime), LastSample);
+	Seek (Index);
+
+	const FPlatformerGhostSample& Sample = Track->GetSample (Index);
+	const FVector Location = FVector (Position) / PlatformerGhost::PositionScale;
+	OutPose = (EPlatformerGhostPose::Type)FMath::Min<uint8> (Sample.Pose, EPlatformerGhostPose::Num - 1);
+
+	if (Index == LastSample) {
+		OutLocation = Location;
+		OutYaw = PlatformerGhost::DequantizeYaw (Sample.Yaw);
+		return;
+	}
+
+	// next sample either starts a keyframe or adds its delta
+	const FPlatformerGhostSample& NextSample = Track->GetSample (Index + 1);
+	FIntVector NextPosition;
+	if ((Index + 1) % Header->KeyframeInterval == 0) {
+		const FPlatformerGhostKeyframe& Keyframe = Track->GetKeyframe (Index + 1);
+		NextPosition = FIntVector (Keyframe.X, Keyframe.Y, Keyframe.Z);
+	} else {
+		NextPosition = Position + FIntVector (NextSample.DeltaX, NextSample.DeltaY, NextSample.DeltaZ);
+	}
+
+	const float Alpha = SampleTime - Index;
+	OutLocation = FMath::Lerp (Location, FVector (NextPosition) / PlatformerGhost::PositionScale, Alpha);
+	OutYaw = FMath::Lerp (FRotator (0.0f, PlatformerGhost::DequantizeYaw (Sample.Yaw), 0.0f), FRotator (0.0f, PlatformerGhost::DequantizeYaw (NextSample.Yaw), 0.0f), Alpha).Yaw;
+}
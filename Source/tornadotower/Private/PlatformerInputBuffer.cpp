@@ -0,0 +1,55 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "tornadotower.h"
+#include "../Public/PlatformerInputBuffer.h"
+
+FPlatformerInputBuffer::FPlatformerInputBuffer ()
+	: BasisYaw (0.0f)
+	, Forward (1.0f, 0.0f, 0.0f)
+	, Right (0.0f, 1.0f, 0.0f) {
+	Reset ();
+}
+
+void FPlatformerInputBuffer::PressJump (float Time) {
+	JumpPressTime = Time;
+}
+
+void FPlatformerInputBuffer::PressSlide (float Time) {
+	SlidePressTime = Time;
+}
+
+bool FPlatformerInputBuffer::ConsumeJump (float Time, float Window) {
+	if (Time - JumpPressTime > Window) {
+		return false;
+	}
+
+	JumpPressTime = -BIG_NUMBER;
+	return true;
+}
+
+bool FPlatformerInputBuffer::ConsumeSlide (float Time, float Window) {
+	if (Time - SlidePressTime > Window) {
+		return false;
+	}
+
+	SlidePressTime = -BIG_NUMBER;
+	return true;
+}
+
+void FPlatformerInputBuffer::Reset () {
+	JumpPressTime = -BIG_NUMBER;
+	SlidePressTime = -BIG_NUMBER;
+}
+
+void FPlatformerInputBuffer::UpdateYawBasis (float Yaw) {
+	if (Yaw == BasisYaw) {
+		return;
+	}
+	BasisYaw = Yaw;
+
+	// same as unit X and Y axes of FRotationMatrix (FRotator (0, Yaw, 0))
+	float SinYaw, CosYaw;
+	FMath::SinCos (&SinYaw, &CosYaw, FMath::DegreesToRadians (Yaw));
+	Forward = FVector (CosYaw, SinYaw, 0.0f);
+	Right = FVector (-SinYaw, CosYaw, 0.0f);
+}
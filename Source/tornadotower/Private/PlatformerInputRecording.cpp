@@ -0,0 +1,286 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "tornadotower.h"
+#include "../Public/PlatformerInputRecording.h"
+#include "../Public/PlatformerCharacter.h"
+#include "../Public/PlatformerPerfCounters.h"
+#include "RenderCore.h"
+#include "Json.h"
+
+DEFINE_LOG_CATEGORY_STATIC (LogPlatformerInput, Log, All);
+
+namespace PlatformerInputRecording {
+
+/** 'PIRC' */
+static const uint32 FileMagic = 0x50495243;
+static const uint32 FileVersion = 1;
+
+static TSharedRef<FJsonObject> MakeVectorObject (const FVector& Value) {
+	TSharedRef<FJsonObject> Object = MakeShareable (new FJsonObject ());
+	Object->SetNumberField (TEXT ("X"), Value.X);
+	Object->SetNumberField (TEXT ("Y"), Value.Y);
+	Object->SetNumberField (TEXT ("Z"), Value.Z);
+	return Object;
+}
+
+}
+
+FPlatformerInputRecording::FPlatformerInputRecording ()
+	: FixedDeltaTime (1.0f / 60.0f)
+	, NumFrames (0)
+	, StartLocation (ForceInitToZero)
+	, StartRotation (ForceInitToZero)
+	, ControlRotation (ForceInitToZero)
+	, EndLocation (ForceInitToZero)
+	, EndVelocity (ForceInitToZero) {
+}
+
+FArchive& operator<< (FArchive& Ar, FPlatformerInputRecording& Recording) {
+	Ar << Recording.FixedDeltaTime << Recording.NumFrames;
+	Ar << Recording.StartLocation << Recording.StartRotation << Recording.ControlRotation;
+	Ar << Recording.EndLocation << Recording.EndVelocity;
+	Ar << Recording.Events;
+	return Ar;
+}
+
+bool FPlatformerInputRecording::SaveToFile (const FString& Filename) const {
+	TArray<uint8> Data;
+	FMemoryWriter Writer (Data);
+
+	uint32 Magic = PlatformerInputRecording::FileMagic;
+	uint32 Version = PlatformerInputRecording::FileVersion;
+	Writer << Magic << Version;
+	Writer << const_cast<FPlatformerInputRecording&> (*this);
+
+	return FFileHelper::SaveArrayToFile (Data, *Filename);
+}
+
+bool FPlatformerInputRecording::LoadFromFile (const FString& Filename) {
+	TArray<uint8> Data;
+	if (!FFileHelper::LoadFileToArray (Data, *Filename)) {
+		return false;
+	}
+
+	FMemoryReader Reader (Data);
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	Reader << Magic << Version;
+	if (Magic != PlatformerInputRecording::FileMagic || Version != PlatformerInputRecording::FileVersion) {
+		return false;
+	}
+
+	Reader << *this;
+	return !Reader.IsError ();
+}
+
+FPlatformerInputRecorder::FPlatformerInputRecorder ()
+	: StartFrame (0)
+	, bRecording (false) {
+	LastAxisValues[0] = LastAxisValues[1] = 0;
+}
+
+void FPlatformerInputRecorder::Start (APlatformerCharacter* Character, const FString& InFilename) {
+	Filename = InFilename;
+	StartFrame = GFrameCounter;
+	LastAxisValues[0] = LastAxisValues[1] = 0;
+	bRecording = true;
+
+	// record at fixed time step, so replay can reproduce every move
+	if (!FApp::UseFixedTimeStep ()) {
+		FApp::SetUseFixedTimeStep (true);
+		FApp::SetFixedDeltaTime (1.0 / 60.0);
+	}
+
+	Recording = FPlatformerInputRecording ();
+	Recording.FixedDeltaTime = FApp::GetFixedDeltaTime ();
+	Recording.StartLocation = Character->GetActorLocation ();
+	Recording.StartRotation = Character->GetActorRotation ();
+	Recording.ControlRotation = Character->GetControlRotation ();
+
+	UE_LOG (LogPlatformerInput, Display, TEXT ("Recording input of %s to %s"), *Character->GetName (), *Filename);
+}
+
+void FPlatformerInputRecorder::Stop (APlatformerCharacter* Character) {
+	if (!bRecording) {
+		return;
+	}
+	bRecording = false;
+
+	Recording.NumFrames = GetFrame ();
+	Recording.EndLocation = Character->GetActorLocation ();
+	Recording.EndVelocity = Character->GetVelocity ();
+
+	if (Recording.SaveToFile (Filename)) {
+		UE_LOG (LogPlatformerInput, Display, TEXT ("Saved %u frames, %d input events to %s"), Recording.NumFrames, Recording.Events.Num (), *Filename);
+	} else {
+		UE_LOG (LogPlatformerInput, Error, TEXT ("Failed to save input recording to %s"), *Filename);
+	}
+}
+
+void FPlatformerInputRecorder::RecordAxis (EPlatformerInputEvent::Type Type, float Value) {
+	if (!bRecording) {
+		return;
+	}
+
+	const int8 Quantized = FPlatformerInputRecording::QuantizeAxis (Value);
+	int8& LastValue = LastAxisValues[Type == EPlatformerInputEvent::MoveForward ? 0 : 1];
+	if (Quantized != LastValue) {
+		LastValue = Quantized;
+		Recording.Events.Add (FPlatformerInputEvent (GetFrame (), Type, Quantized));
+	}
+}
+
+void FPlatformerInputRecorder::RecordAction (EPlatformerInputEvent::Type Type) {
+	if (bRecording) {
+		Recording.Events.Add (FPlatformerInputEvent (GetFrame (), Type, 0));
+	}
+}
+
+uint32 FPlatformerInputRecorder::GetFrame () const {
+	return (uint32)(GFrameCounter - StartFrame);
+}
+
+FPlatformerInputReplay::FPlatformerInputReplay ()
+	: StartFrame (0)
+	, NextEvent (0)
+	, bReplaying (false) {
+	AxisValues[0] = AxisValues[1] = 0.0f;
+}
+
+bool FPlatformerInputReplay::Start (APlatformerCharacter* Character, const FString& Filename) {
+	if (!Recording.LoadFromFile (Filename)) {
+		UE_LOG (LogPlatformerInput, Error, TEXT ("Failed to load input recording %s"), *Filename);
+		return false;
+	}
+
+	// replay has to run at recorded time step to end up in the same state
+	FApp::SetUseFixedTimeStep (true);
+	FApp::SetFixedDeltaTime (Recording.FixedDeltaTime);
+
+	Character->TeleportTo (Recording.StartLocation, Recording.StartRotation, false, true);
+	if (Character->Controller) {
+		Character->Controller->SetControlRotation (Recording.ControlRotation);
+	}
+
+	StartFrame = GFrameCounter;
+	NextEvent = 0;
+	AxisValues[0] = AxisValues[1] = 0.0f;
+	FrameTimes.Reset (Recording.NumFrames);
+	bReplaying = true;
+
+	UE_LOG (LogPlatformerInput, Display, TEXT ("Replaying %u frames, %d input events from %s"), Recording.NumFrames, Recording.Events.Num (), *Filename);
+	return true;
+}
+
+bool FPlatformerInputReplay::Tick (APlatformerCharacter* Character) {
+	if (!bReplaying) {
+		return false;
+	}
+
+	const uint32 Frame = (uint32)(GFrameCounter - StartFrame);
+
+	// game thread time of previous frame
+	if (Frame > 0) {
+		FrameTimes.Add (FPlatformTime::ToMilliseconds (GGameThreadTime));
+	}
+
+	if (Frame >= Recording.NumFrames) {
+		bReplaying = false;
+		return false;
+	}
+
+	while (NextEvent < Recording.Events.Num () && Recording.Events[NextEvent].Frame <= Frame) {
+		const FPlatformerInputEvent& Event = Recording.Events[NextEvent++];
+		switch (Event.Type) {
+			case EPlatformerInputEvent::MoveForward:
+				AxisValues[0] = FPlatformerInputRecording::DequantizeAxis (Event.Value);
+				break;
+
+			case EPlatformerInputEvent::MoveRight:
+				AxisValues[1] = FPlatformerInputRecording::DequantizeAxis (Event.Value);
+				break;
+
+			case EPlatformerInputEvent::Jump:
+				Character->Jump ();
+				break;
+
+			case EPlatformerInputEvent::StopJumping:
+				Character->StopJumping ();
+				break;
+
+			case EPlatformerInputEvent::StartSlide:
+				Character->OnStartSlide ();
+				break;
+
+			case EPlatformerInputEvent::StopSlide:
+				Character->OnStopSlide ();
+				break;
+		}
+	}
+
+	// axes are held until they change, same as bound input
+	Character->MoveForward (AxisValues[0]);
+	Character->MoveRight (AxisValues[1]);
+	return true;
+}
+
+void FPlatformerInputReplay::Report (APlatformerCharacter* Character, const FString& ReportFilename) const {
+	using namespace PlatformerInputRecording;
+
+	TArray<float> Sorted = FrameTimes;
+	Sorted.Sort ();
+
+	float TotalTime = 0.0f;
+	for (float Time : Sorted) {
+		TotalTime += Time;
+	}
+
+	const float AvgTime = Sorted.Num () > 0 ? TotalTime / Sorted.Num () : 0.0f;
+	const float MaxTime = Sorted.Num () > 0 ? Sorted.Last () : 0.0f;
+	const FVector EndLocation = Character->GetActorLocation ();
+	const FVector EndVelocity = Character->GetVelocity ();
+	const float LocationError = FVector::Dist (EndLocation, Recording.EndLocation);
+	const uint8 EndMovementMode = Character->GetCharacterMovement ()->MovementMode;
+
+	UE_LOG (LogPlatformerInput, Display, TEXT ("Replayed %d frames: game thread avg %.3f ms, p50 %.3f ms, p95 %.3f ms, p99 %.3f ms, max %.3f ms"),
+		Sorted.Num (), AvgTime, FPlatformerPerfCounters::GetPercentile (Sorted, 0.5f), FPlatformerPerfCounters::GetPercentile (Sorted, 0.95f), FPlatformerPerfCounters::GetPercentile (Sorted, 0.99f), MaxTime);
+	UE_LOG (LogPlatformerInput, Display, TEXT ("Final location %s (recorded %s, error %.3f), velocity %s, movement mode %d, sliding %d"),
+		*EndLocation.ToString (), *Recording.EndLocation.ToString (), LocationError, *EndVelocity.ToString (), EndMovementMode, Character->IsSliding () ? 1 : 0);
+
+	if (ReportFilename.IsEmpty ()) {
+		return;
+	}
+
+	TSharedRef<FJsonObject> Root = MakeShareable (new FJsonObject ());
+	Root->SetNumberField (TEXT ("Frames"), Sorted.Num ());
+	Root->SetNumberField (TEXT ("FixedDeltaTime"), Recording.FixedDeltaTime);
+	Root->SetNumberField (TEXT ("GameThreadAvgMs"), AvgTime);
+	Root->SetNumberField (TEXT ("GameThreadP50Ms"), FPlatformerPerfCounters::GetPercentile (Sorted, 0.5f));
+	Root->SetNumberField (TEXT ("GameThreadP95Ms"), FPlatformerPerfCounters::GetPercentile (Sorted, 0.95f));
+	Root->SetNumberField (TEXT ("GameThreadP99Ms"), FPlatformerPerfCounters::GetPercentile (Sorted, 0.99f));
+	Root->SetNumberField (TEXT ("GameThreadMaxMs"), MaxTime);
+
+	TArray<TSharedPtr<FJsonValue>> Frames;
+	for (float Time : FrameTimes) {
+		Frames.Add (MakeShareable (new FJsonValueNumber (Time)));
+	}
+	Root->SetArrayField (TEXT ("GameThreadMs"), Frames);
+
+	TSharedRef<FJsonObject> Pawn = MakeShareable (new FJsonObject ());
+	Pawn->SetObjectField (TEXT ("Location"), MakeVectorObject (EndLocation));
+	Pawn->SetObjectField (TEXT ("RecordedLocation"), MakeVectorObject (Recording.EndLocation));
+	Pawn->SetNumberField (TEXT ("LocationError"), LocationError);
+	Pawn->SetObjectField (TEXT ("Velocity"), MakeVectorObject (EndVelocity));
+	Pawn->SetNumberField (TEXT ("MovementMode"), EndMovementMode);
+	Pawn->SetBoolField (TEXT ("Sliding"), Character->IsSliding ());
+	Root->SetObjectField (TEXT ("FinalState"), Pawn);
+
+	FString Output;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create (&Output);
+	FJsonSerializer::Serialize (Root, Writer);
+	if (FFileHelper::SaveStringToFile (Output, *ReportFilename)) {
+		UE_LOG (LogPlatformerInput, Display, TEXT ("Replay report written to %s"), *ReportFilename);
+	} else {
+		UE_LOG (LogPlatformerInput, Error, TEXT ("Failed to write replay report to %s"), *ReportFilename);
+	}
+}
@@ -0,0 +1,6 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "tornadotower.h"
+#include "../Public/PlatformerLog.h"
+
+DEFINE_LOG_CATEGORY (LogPlatformer);
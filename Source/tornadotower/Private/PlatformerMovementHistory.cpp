@@ -0,0 +1,78 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "tornadotower.h"
+#include "../Public/PlatformerMovementHistory.h"
+
+FPlatformerMovementHistory::FPlatformerMovementHistory ()
+	: Head (0)
+	, Count (0) {
+}
+
+void FPlatformerMovementHistory::Init (int32 Capacity) {
+	Snapshots.Reset ();
+	Snapshots.SetNum (FMath::Max (Capacity, 2));
+	Reset ();
+}
+
+void FPlatformerMovementHistory::Reset () {
+	Head = 0;
+	Count = 0;
+}
+
+void FPlatformerMovementHistory::Record (const FPlatformerMovementSnapshot& Snapshot) {
+	check (IsInitialized ());
+
+	if (Count > 0) {
+		const float NewestTimestamp = GetOrdered (Count - 1).Timestamp;
+		if (Snapshot.Timestamp < NewestTimestamp) {
+			// client time stamps were reset
+			Reset ();
+		} else if (Snapshot.Timestamp == NewestTimestamp) {
+			// several updates in the same move, keep the last one
+			Head = (Head - 1 + Snapshots.Num ()) % Snapshots.Num ();
+			Count--;
+		}
+	}
+
+	Snapshots[Head] = Snapshot;
+	Head = (Head + 1) % Snapshots.Num ();
+	Count = FMath::Min (Count + 1, Snapshots.Num ());
+}
+
+bool FPlatformerMovementHistory::Sample (float Timestamp, FPlatformerMovementSnapshot& OutSnapshot) const {
+	if (Count == 0 || Timestamp < GetOrdered (0).Timestamp) {
+		return false;
+	}
+
+	const FPlatformerMovementSnapshot& Newest = GetOrdered (Count - 1);
+	if (Timestamp > Newest.Timestamp) {
+		return false;
+	}
+	if (Timestamp == Newest.Timestamp) {
+		OutSnapshot = Newest;
+		return true;
+	}
+
+	// find first snapshot newer than Timestamp
+	int32 Low = 1;
+	int32 High = Count - 1;
+	while (Low < High) {
+		const int32 Mid = (Low + High) / 2;
+		if (GetOrdered (Mid).Timestamp <= Timestamp) {
+			Low = Mid + 1;
+		} else {
+			High = Mid;
+		}
+	}
+
+	const FPlatformerMovementSnapshot& Before = GetOrdered (Low - 1);
+	const FPlatformerMovementSnapshot& After = GetOrdered (Low);
+	const float Alpha = (Timestamp - Before.Timestamp) / FMath::Max (After.Timestamp - Before.Timestamp, KINDA_SMALL_NUMBER);
+
+	// discrete state comes from the snapshot before requested time
+	OutSnapshot = Before;
+	OutSnapshot.Timestamp = Timestamp;
+	OutSnapshot.Location = FMath::Lerp (Before.Location, After.Location, Alpha);
+	OutSnapshot.Velocity = FMath::Lerp (Before.Velocity, After.Velocity, Alpha);
+	return true;
+}
@@ -0,0 +1,65 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "tornadotower.h"
+#include "../Public/PlatformerObstacleIndex.h"
+
+APlatformerObstacleIndex::APlatformerObstacleIndex (const FObjectInitializer& ObjectInitializer)
+	: Super (ObjectInitializer) {
+	CellSize = 400.0f;
+}
+
+void APlatformerObstacleIndex::PostInitializeComponents () {
+	Super::PostInitializeComponents ();
+
+	BuildGrid ();
+}
+
+APlatformerObstacleIndex* APlatformerObstacleIndex::Get (UWorld* World) {
+	if (World) {
+		for (TActorIterator<APlatformerObstacleIndex> It (World); It; ++It) {
+			return *It;
+		}
+	}
+
+	return nullptr;
+}
+
+void APlatformerObstacleIndex::SetObstacles (const TArray<FPlatformerObstacleTop>& InObstacles, float InCellSize) {
+	Obstacles = InObstacles;
+	CellSize = InCellSize;
+	BuildGrid ();
+}
+
+bool APlatformerObstacleIndex::FindObstacleTop (const FVector& Location, float MinZ, float MaxZ, FPlatformerObstacleTop& OutTop) const {
+	const TArray<int32>* Candidates = Grid.Find (Location);
+	if (!Candidates) {
+		return false;
+	}
+
+	// same as tracing down from MaxZ to MinZ: highest top wins
+	const FPlatformerObstacleTop* Best = nullptr;
+	for (int32 Idx : *Candidates) {
+		const FPlatformerObstacleTop& Top = Obstacles[Idx];
+		if (Location.X >= Top.Min.X && Location.X <= Top.Max.X &&
+			Location.Y >= Top.Min.Y && Location.Y <= Top.Max.Y &&
+			Top.TopZ >= MinZ && Top.TopZ <= MaxZ &&
+			(!Best || Top.TopZ > Best->TopZ))
+		{
+			Best = &Top;
+		}
+	}
+
+	if (Best) {
+		OutTop = *Best;
+		return true;
+	}
+
+	return false;
+}
+
+void APlatformerObstacleIndex::BuildGrid () {
+	Grid.Init (FMath::Max (CellSize, 1.0f));
+	for (int32 Idx = 0; Idx < Obstacles.Num (); Idx++) {
+		Grid.Add (Idx, Obstacles[Idx].GetBox ());
+	}
+}
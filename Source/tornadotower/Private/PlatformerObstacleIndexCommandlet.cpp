@@ -0,0 +1,149 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "tornadotower.h"
+#include "../Public/PlatformerObstacleIndexCommandlet.h"
+#include "../Public/PlatformerObstacleIndex.h"
+
+DEFINE_LOG_CATEGORY_STATIC (LogPlatformerObstacleIndex, Log, All);
+
+/**
+* returns world box of Primitive's collision if it is a single box with flat top and sides along world axes
+* tops of ramps, wedges and rotated boxes don't fit a box and are left to the vault trace
+*/
+static bool GetAxisAlignedBoxCollision (UPrimitiveComponent* Primitive, FBox& OutBox) {
+	const UBodySetup* BodySetup = Primitive->GetBodySetup ();
+	if (!BodySetup) {
+		return false;
+	}
+
+	const FKAggregateGeom& Geom = BodySetup->AggGeom;
+	if (Geom.BoxElems.Num () != 1 || Geom.SphereElems.Num () > 0 || Geom.SphylElems.Num () > 0 || Geom.ConvexElems.Num () > 0) {
+		return false;
+	}
+
+	// quarter turns of yaw keep sides along world axes
+	const FKBoxElem& Box = Geom.BoxElems[0];
+	const FTransform ComponentTransform = Primitive->GetComponentTransform ();
+	const FRotator Rotation = (Box.GetTransform () * ComponentTransform).Rotator ();
+	const float YawRemainder = FMath::Fmod (FMath::Abs (Rotation.Yaw) + 0.25f, 90.0f);
+	if (!FMath::IsNearlyZero (Rotation.Pitch, 0.25f) || !FMath::IsNearlyZero (Rotation.Roll, 0.25f) || YawRemainder > 0.5f) {
+		return false;
+	}
+
+	OutBox = Box.CalcAABB (ComponentTransform, 1.0f);
+	return true;
+}
+
+UPlatformerObstacleIndexCommandlet::UPlatformerObstacleIndexCommandlet (const FObjectInitializer& ObjectInitializer)
+	: Super (ObjectInitializer) {
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UPlatformerObstacleIndexCommandlet::Main (const FString& Params) {
+#if WITH_EDITOR
+	FString MapName;
+	if (!FParse::Value (*Params, TEXT ("Map="), MapName)) {
+		UE_LOG (LogPlatformerObstacleIndex, Error, TEXT ("Missing -Map= parameter"));
+		return 1;
+	}
+
+	float MinHeight = 30.0f;
+	float MaxHeight = 400.0f;
+	float MaxFootprint = 2000.0f;
+	float CellSize = 400.0f;
+	FParse::Value (*Params, TEXT ("MinHeight="), MinHeight);
+	FParse::Value (*Params, TEXT ("MaxHeight="), MaxHeight);
+	FParse::Value (*Params, TEXT ("MaxFootprint="), MaxFootprint);
+	FParse::Value (*Params, TEXT ("CellSize="), CellSize);
+
+	UPackage* Package = LoadPackage (NULL, *MapName, LOAD_None);
+	UWorld* World = Package ? UWorld::FindWorldInPackage (Package) : NULL;
+	if (!World) {
+		UE_LOG (LogPlatformerObstacleIndex, Error, TEXT ("Failed to load map %s"), *MapName);
+		return 1;
+	}
+
+	World->WorldType = EWorldType::Editor;
+	World->AddToRoot ();
+	if (!World->bIsWorldInitialized) {
+		UWorld::InitializationValues IVS;
+		IVS.RequiresHitProxies (false);
+		IVS.ShouldSimulatePhysics (false);
+		IVS.EnableTraceCollision (false);
+		IVS.CreateNavigation (false);
+		IVS.CreateAISystem (false);
+		IVS.AllowAudioPlayback (false);
+		IVS.CreatePhysicsScene (false);
+		World->InitWorld (IVS);
+		World->UpdateWorldComponents (true, false);
+	}
+
+	TArray<FPlatformerObstacleTop> Obstacles;
+	for (TActorIterator<AActor> It (World); It; ++It) {
+		AActor* Actor = *It;
+		if (Actor->IsA<APlatformerObstacleIndex> ()) {
+			continue;
+		}
+
+		TInlineComponentArray<UPrimitiveComponent*> Primitives (Actor);
+		for (UPrimitiveComponent* Primitive : Primitives) {
+			if (!Primitive->IsRegistered () ||
+				Primitive->Mobility != EComponentMobility::Static ||
+				!Primitive->IsCollisionEnabled () ||
+				Primitive->GetCollisionResponseToChannel (ECC_Pawn) != ECR_Block)
+			{
+				continue;
+			}
+
+			FBox Bounds;
+			if (!GetAxisAlignedBoxCollision (Primitive, Bounds)) {
+				continue;
+			}
+
+			const FVector Size = Bounds.GetSize ();
+			if (Size.Z < MinHeight || Size.Z > MaxHeight || Size.X > MaxFootprint || Size.Y > MaxFootprint) {
+				continue;
+			}
+
+			FPlatformerObstacleTop Top;
+			Top.Min = FVector2D (Bounds.Min);
+			Top.Max = FVector2D (Bounds.Max);
+			Top.TopZ = Bounds.Max.Z;
+			Top.BottomZ = Bounds.Min.Z;
+			Top.Component = Primitive;
+			Obstacles.Add (Top);
+		}
+	}
+
+	APlatformerObstacleIndex* Index = APlatformerObstacleIndex::Get (World);
+	if (!Index) {
+		Index = World->SpawnActor<APlatformerObstacleIndex> ();
+	}
+	if (!Index) {
+		UE_LOG (LogPlatformerObstacleIndex, Error, TEXT ("Failed to create obstacle index in %s"), *MapName);
+		return 1;
+	}
+
+	Index->SetObstacles (Obstacles, CellSize);
+	Package->MarkPackageDirty ();
+
+	const FString Filename = FPackageName::LongPackageNameToFilename (Package->GetName (), FPackageName::GetMapPackageExtension ());
+	const bool bSaved = UPackage::SavePackage (Package, World, RF_Standalone, *Filename);
+
+	World->RemoveFromRoot ();
+
+	if (!bSaved) {
+		UE_LOG (LogPlatformerObstacleIndex, Error, TEXT ("Failed to save %s"), *Filename);
+		return 1;
+	}
+
+	UE_LOG (LogPlatformerObstacleIndex, Display, TEXT ("Baked %d obstacles into %s"), Obstacles.Num (), *Filename);
+	return 0;
+#else
+	UE_LOG (LogPlatformerObstacleIndex, Error, TEXT ("Obstacle index can only be baked in editor builds"));
+	return 1;
+#endif
+}
@@ -0,0 +1,159 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "tornadotower.h"
+#include "../Public/PlatformerPerfCounters.h"
+
+DEFINE_STAT (STAT_PlatformerMovementTick);
+DEFINE_STAT (STAT_PlatformerPhysWalking);
+DEFINE_STAT (STAT_PlatformerUpdateSlideVelocity);
+DEFINE_STAT (STAT_PlatformerRestoreCollisionHeight);
+DEFINE_STAT (STAT_PlatformerCharacterTick);
+DEFINE_STAT (STAT_PlatformerClimbOverObstacle);
+DEFINE_STAT (STAT_PlatformerMoveBlockedBy);
+DEFINE_STAT (STAT_PlatformerCollisionQuery);
+DEFINE_STAT (STAT_PlatformerBatchMovement);
+DEFINE_STAT (STAT_PlatformerCrowdTick);
+
+DEFINE_STAT (STAT_PlatformerSlideStarts);
+DEFINE_STAT (STAT_PlatformerSlideEnds);
+DEFINE_STAT (STAT_PlatformerOverlaps);
+DEFINE_STAT (STAT_PlatformerTraces);
+DEFINE_STAT (STAT_PlatformerCapsuleResizes);
+
+DEFINE_LOG_CATEGORY_STATIC (LogPlatformerPerf, Log, All);
+
+bool FPlatformerPerfCounters::bEnabled = false;
+uint32 FPlatformerPerfCounters::Cycles[EPlatformerCycleCounter::Num] = { 0 };
+uint32 FPlatformerPerfCounters::Calls[EPlatformerCallCounter::Num] = { 0 };
+
+void FPlatformerPerfCounters::Reset () {
+	FMemory::Memzero (Cycles);
+	FMemory::Memzero (Calls);
+}
+
+const TCHAR* FPlatformerPerfCounters::GetCycleCounterName (EPlatformerCycleCounter::Type Counter) {
+	switch (Counter) {
+		case EPlatformerCycleCounter::MovementTick:				return TEXT ("MovementTick");
+		case EPlatformerCycleCounter::PhysWalking:				return TEXT ("PhysWalking");
+		case EPlatformerCycleCounter::UpdateSlideVelocity:		return TEXT ("UpdateSlideVelocity");
+		case EPlatformerCycleCounter::RestoreCollisionHeight:	return TEXT ("RestoreCollisionHeight");
+		case EPlatformerCycleCounter::CharacterTick:			return TEXT ("CharacterTick");
+		case EPlatformerCycleCounter::ClimbOverObstacle:		return TEXT ("ClimbOverObstacle");
+		case EPlatformerCycleCounter::MoveBlockedBy:			return TEXT ("MoveBlockedBy");
+		case EPlatformerCycleCounter::CollisionQuery:			return TEXT ("CollisionQuery");
+		case EPlatformerCycleCounter::BatchMovement:			return TEXT ("BatchMovement");
+		case EPlatformerCycleCounter::CrowdTick:				return TEXT ("CrowdTick");
+		default:												return TEXT ("Unknown");
+	}
+}
+
+const TCHAR* FPlatformerPerfCounters::GetCallCounterName (EPlatformerCallCounter::Type Counter) {
+	switch (Counter) {
+		case EPlatformerCallCounter::SlideStarts:		return TEXT ("SlideStarts");
+		case EPlatformerCallCounter::SlideEnds:			return TEXT ("SlideEnds");
+		case EPlatformerCallCounter::Overlaps:			return TEXT ("Overlaps");
+		case EPlatformerCallCounter::Traces:			return TEXT ("Traces");
+		case EPlatformerCallCounter::CapsuleResizes:	return TEXT ("CapsuleResizes");
+		default:										return TEXT ("Unknown");
+	}
+}
+
+float FPlatformerPerfCounters::GetPercentile (const TArray<float>& Sorted, float Percentile) {
+	if (Sorted.Num () == 0) {
+		return 0.0f;
+	}
+	const int32 Idx = FMath::Clamp (FMath::CeilToInt (Percentile * Sorted.Num ()) - 1, 0, Sorted.Num () - 1);
+	return Sorted[Idx];
+}
+
+/**
+* CSV export of FPlatformerPerfCounters, one row per frame:
+* frame, frame time and every cycle counter in ms, followed by every call counter.
+*/
+namespace PlatformerCsvCapture {
+
+static FArchive* File = NULL;
+static FString Filename;
+static FDelegateHandle EndFrameHandle;
+static uint64 StartFrame = 0;
+static double LastFrameTime = 0.0;
+
+static void WriteLine (const FString& Line) {
+	FTCHARToUTF8 Utf8 (*Line);
+	File->Serialize ((void*)Utf8.Get (), Utf8.Length ());
+}
+
+static void OnEndFrame () {
+	const double Now = FPlatformTime::Seconds ();
+	FString Line = FString::Printf (TEXT ("%llu,%.3f"), (uint64)(GFrameCounter - StartFrame), (Now - LastFrameTime) * 1000.0);
+	LastFrameTime = Now;
+
+	for (int32 Idx = 0; Idx < EPlatformerCycleCounter::Num; Idx++) {
+		Line += FString::Printf (TEXT (",%.4f"), FPlatformTime::ToMilliseconds (FPlatformerPerfCounters::Cycles[Idx]));
+	}
+	for (int32 Idx = 0; Idx < EPlatformerCallCounter::Num; Idx++) {
+		Line += FString::Printf (TEXT (",%u"), FPlatformerPerfCounters::Calls[Idx]);
+	}
+	Line += TEXT ("\n");
+	WriteLine (Line);
+
+	FPlatformerPerfCounters::Reset ();
+}
+
+static void Stop () {
+	if (!File) {
+		return;
+	}
+
+	FCoreDelegates::OnEndFrame.Remove (EndFrameHandle);
+	FPlatformerPerfCounters::bEnabled = false;
+
+	File->Close ();
+	delete File;
+	File = NULL;
+
+	UE_LOG (LogPlatformerPerf, Display, TEXT ("Platformer CSV capture of %llu frames written to %s"), (uint64)(GFrameCounter - StartFrame), *Filename);
+}
+
+static void Start (const TArray<FString>& Args) {
+	Stop ();
+
+	Filename = (Args.Num () > 0) ? Args[0] : FPaths::ProfilingDir () / TEXT ("Platformer") / FString::Printf (TEXT ("Platformer-%s.csv"), *FDateTime::Now ().ToString ());
+	File = IFileManager::Get ().CreateFileWriter (*Filename);
+	if (!File) {
+		UE_LOG (LogPlatformerPerf, Error, TEXT ("Failed to open %s for platformer CSV capture"), *Filename);
+		return;
+	}
+
+	FString Header = TEXT ("Frame,FrameTime");
+	for (int32 Idx = 0; Idx < EPlatformerCycleCounter::Num; Idx++) {
+		Header += TEXT (",");
+		Header += FPlatformerPerfCounters::GetCycleCounterName ((EPlatformerCycleCounter::Type)Idx);
+	}
+	for (int32 Idx = 0; Idx < EPlatformerCallCounter::Num; Idx++) {
+		Header += TEXT (",");
+		Header += FPlatformerPerfCounters::GetCallCounterName ((EPlatformerCallCounter::Type)Idx);
+	}
+	Header += TEXT ("\n");
+	WriteLine (Header);
+
+	StartFrame = GFrameCounter;
+	LastFrameTime = FPlatformTime::Seconds ();
+	FPlatformerPerfCounters::Reset ();
+	FPlatformerPerfCounters::bEnabled = true;
+	EndFrameHandle = FCoreDelegates::OnEndFrame.AddStatic (&OnEndFrame);
+
+	UE_LOG (LogPlatformerPerf, Display, TEXT ("Platformer CSV capture started: %s"), *Filename);
+}
+
+static FAutoConsoleCommand StartCommand (
+	TEXT ("Platformer.CsvCapture.Start"),
+	TEXT ("Starts writing platformer perf counters to CSV, one row per frame. Optional argument: file name"),
+	FConsoleCommandWithArgsDelegate::CreateStatic (&Start));
+
+static FAutoConsoleCommand StopCommand (
+	TEXT ("Platformer.CsvCapture.Stop"),
+	TEXT ("Stops platformer CSV capture and closes the file"),
+	FConsoleCommandDelegate::CreateStatic (&Stop));
+
+}
@@ -0,0 +1,10 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "tornadotower.h"
+#include "../Public/PlatformerPhysicalMaterial.h"
+
+UPlatformerPhysicalMaterial::UPlatformerPhysicalMaterial (const FObjectInitializer& ObjectInitializer)
+	: Super (ObjectInitializer) {
+	SlideFrictionScale = 1.0f;
+	SlideAccelerationScale = 1.0f;
+}
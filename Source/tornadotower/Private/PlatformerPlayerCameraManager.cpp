@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "tornadotower.h"
+#include "../Public/PlatformerPlayerCameraManager.h"
+#include "../Public/PlatformerCharacter.h"
+#include "../Public/PlatformerPerfCounters.h"
+
+APlatformerPlayerCameraManager::APlatformerPlayerCameraManager (const FObjectInitializer& ObjectInitializer)
+	: Super (ObjectInitializer) {
+	HeightInterpSpeed = 5.0f;
+	ProbeMinMove = 20.0f;
+	ProbeMinAngle = 2.0f;
+
+	CameraBaseZ = 0.0f;
+	LastProbePivot = FVector::ZeroVector;
+	LastProbeRotation = FRotator::ZeroRotator;
+	ProbeArmFraction = 1.0f;
+	bHasProbe = false;
+}
+
+void APlatformerPlayerCameraManager::UpdateViewTargetInternal (FTViewTarget& OutVT, float DeltaTime) {
+	APlatformerCharacter* MyPawn = Cast<APlatformerCharacter> (OutVT.Target);
+	const USpringArmComponent* Boom = MyPawn ? MyPawn->GetCameraBoom () : NULL;
+	if (!Boom || !PCOwner) {
+		Super::UpdateViewTargetInternal (OutVT, DeltaTime);
+		return;
+	}
+
+	if (CameraTarget.Get () != MyPawn) {
+		CameraTarget = MyPawn;
+		CameraBaseZ = MyPawn->GetActorLocation ().Z;
+		bHasProbe = false;
+	}
+
+	UpdateCameraHeight (MyPawn, DeltaTime);
+
+	const FVector PawnLocation = MyPawn->GetActorLocation ();
+	const FVector Pivot (PawnLocation.X, PawnLocation.Y, CameraBaseZ);
+	const FRotator ViewRotation = PCOwner->GetControlRotation ();
+
+	// same arm as camera boom: from pivot with target offset, back along view direction, then socket offset
+	const FVector ArmOrigin = Pivot + Boom->TargetOffset;
+	const FVector ArmEnd = ArmOrigin - ViewRotation.Vector () * Boom->TargetArmLength + ViewRotation.RotateVector (Boom->SocketOffset);
+
+	if (NeedsCollisionProbe (Pivot, ViewRotation)) {
+		PLATFORMER_INC_CALL_COUNTER (Traces);
+
+		FCollisionQueryParams QueryParams (NAME_None, false, MyPawn);
+		FHitResult Hit;
+		GetWorld ()->SweepSingleByChannel (Hit, ArmOrigin, ArmEnd, FQuat::Identity, Boom->ProbeChannel, FCollisionShape::MakeSphere (Boom->ProbeSize), QueryParams);
+
+		ProbeArmFraction = Hit.bBlockingHit ? Hit.Time : 1.0f;
+		LastProbePivot = Pivot;
+		LastProbeRotation = ViewRotation;
+		bHasProbe = true;
+	}
+
+	OutVT.POV.Location = FMath::Lerp (ArmOrigin, ArmEnd, ProbeArmFraction);
+	OutVT.POV.Rotation = ViewRotation;
+	OutVT.POV.FOV = DefaultFOV;
+}
+
+void APlatformerPlayerCameraManager::UpdateCameraHeight (const APlatformerCharacter* MyPawn, float DeltaTime) {
+	const float PawnZ = MyPawn->GetActorLocation ().Z;
+	const UCharacterMovementComponent* MoveComp = MyPawn->GetCharacterMovement ();
+
+	if (MoveComp && MoveComp->IsMovingOnGround ()) {
+		CameraBaseZ = FMath::FInterpTo (CameraBaseZ, PawnZ, DeltaTime, HeightInterpSpeed);
+	} else {
+		// camera stays on the ground during jumps, follows only when pawn gets past threshold
+		const float Threshold = MyPawn->GetCameraHeightChangeThreshold ();
+		CameraBaseZ = FMath::Clamp (CameraBaseZ, PawnZ - Threshold, PawnZ + Threshold);
+	}
+}
+
+bool APlatformerPlayerCameraManager::NeedsCollisionProbe (const FVector& Pivot, const FRotator& ViewRotation) const {
+	return !bHasProbe ||
+		(Pivot - LastProbePivot).SizeSquared () > FMath::Square (ProbeMinMove) ||
+		!ViewRotation.Equals (LastProbeRotation, ProbeMinAngle);
+}
@@ -1,10 +1,12 @@
 #include "tornadotower.h"
 #include "../Public/PlatformerPlayerController.h"
+#include "../Public/PlatformerPlayerCameraManager.h"
+#include "../Public/PlatformerRoundManager.h"
 
 APlatformerPlayerController::APlatformerPlayerController(const FObjectInitializer& ObjectInitializer) 
 	: Super(ObjectInitializer)
 {
-	//PlayerCameraManagerClass = APlatformerPlayerCameraManager::StaticClass();
+	PlayerCameraManagerClass = APlatformerPlayerCameraManager::StaticClass();
 	bEnableClickEvents = true;
 	bEnableTouchEvents = true;
 }
@@ -38,21 +40,19 @@ void APlatformerPlayerController::OnToggleInGameMenu()
 
 bool APlatformerPlayerController::TryStartingGame()
 {
-	/*APlatformerGameMode* MyGame = GetWorld()->GetAuthGameMode<APlatformerGameMode>();
-	if (MyGame)
+	APlatformerRoundManager* RoundManager = APlatformerRoundManager::Get(GetWorld());
+	if (RoundManager)
 	{
-		const EGameState::Type GameState = MyGame->GetGameState();
-		switch (GameState)
+		switch (RoundManager->GetRoundState())
 		{
-			case EGameState::Waiting:
-				MyGame->StartRound();
+			case EPlatformerRoundState::Waiting:
+				RoundManager->StartRound();
 				return true;
 
-			case EGameState::Finished:
-				MyGame->TryRestartRound();
-				return true;
+			case EPlatformerRoundState::Finished:
+				return RoundManager->TryRestartRound();
 		}
-	}*/
+	}
 
 	return false;
 }
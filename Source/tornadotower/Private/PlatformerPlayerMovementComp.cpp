@@ -3,6 +3,14 @@
 #include "tornadotower.h"
 #include "../Public/PlatformerPlayerMovementComp.h"
 #include "../Public/PlatformerCharacter.h"
+#include "../Public/PlatformerSlideKernel.h"
+#include "../Public/PlatformerPhysicalMaterial.h"
+#include "../Public/PlatformerPerfCounters.h"
+#include "../Public/PlatformerBatchMovementManager.h"
+#include "../Public/PlatformerTrace.h"
+
+/** slide exit tests skipped in a row before the world is queried again */
+static const int32 MaxSlideExitTestsSkipped = 8;
 
 UPlatformerPlayerMovementComp::UPlatformerPlayerMovementComp (const FObjectInitializer& ObjectInitializer)
 	: Super (ObjectInitializer) {
@@ -19,6 +27,181 @@ UPlatformerPlayerMovementComp::UPlatformerPlayerMovementComp (const FObjectIniti
 
 	ModSpeedObstacleHit = 0.0f;
 	ModSpeedLedgeGrab = 0.8f;
+	ModSpeedLookAheadVault = 1.0f;
+
+	bEnableLookAheadVault = true;
+	LookAheadMinSpeed = 400.0f;
+	LookAheadFrames = 3.0f;
+	LookAheadTraceFrame = 0;
+
+	JumpBufferTime = 0.1f;
+	SlideBufferTime = 0.1f;
+	CoyoteTime = 0.1f;
+	TimeSinceGrounded = 0.0f;
+	bJumpedSinceGrounded = false;
+	bBufferedSlide = false;
+
+	bEnableMovementLOD = true;
+	ReducedLODDistance = 3000.0f;
+	ReducedLODNotRenderedTime = 0.5f;
+	ReducedLODTickInterval = 0.1f;
+	MovementLODCheckInterval = 0.25f;
+	SlideFixedTimeStep = 1.0f / 60.0f;
+
+	MovementHistorySize = 128;
+	bUseBatchMovement = false;
+	bMovedByBatch = false;
+
+	StandingRadius = 0.0f;
+	StandingHalfHeight = 0.0f;
+	StandingMeshRelativeLocation = FVector::ZeroVector;
+
+	LedgeGrabReachForward = 30.0f;
+	LedgeGrabReachUp = 40.0f;
+
+	VaultClimbEndTime = 0.1f;
+	VaultState = EPlatformerVaultState::None;
+	VaultStateTimeLeft = 0.0f;
+
+	SlideSurfaceFrictionScale = 1.0f;
+	SlideSurfaceAccelerationScale = 1.0f;
+
+	CachedTimeDilation = 1.0f;
+	SlideTimeAccumulator = 0.0f;
+	MovementLODCheckTimeLeft = 0.0f;
+	MovementLOD = EPlatformerMovementLOD::Full;
+	SlideExitBlockersBounds.Init ();
+	SlideExitBlockedLocation = FVector::ZeroVector;
+	NumSlideExitTestsSkipped = 0;
+}
+
+void UPlatformerPlayerMovementComp::InitializeComponent () {
+	Super::InitializeComponent ();
+
+	CacheStandingCollision ();
+}
+
+void UPlatformerPlayerMovementComp::BeginPlay () {
+	Super::BeginPlay ();
+
+	ClimbMarkerRegistry = APlatformerClimbMarkerRegistry::Get (GetWorld ());
+
+	if (bUseBatchMovement) {
+		SetUseBatchMovement (true);
+	}
+}
+
+void UPlatformerPlayerMovementComp::EndPlay (const EEndPlayReason::Type EndPlayReason) {
+	if (BatchMovementManager.IsValid ()) {
+		BatchMovementManager->UnregisterMovement (this);
+		BatchMovementManager.Reset ();
+	}
+
+	Super::EndPlay (EndPlayReason);
+}
+
+void UPlatformerPlayerMovementComp::CacheStandingCollision () {
+	if (!CharacterOwner) {
+		return;
+	}
+
+	const UCapsuleComponent* Capsule = CharacterOwner->GetCapsuleComponent ();
+	StandingRadius = Capsule->GetUnscaledCapsuleRadius ();
+	StandingHalfHeight = Capsule->GetUnscaledCapsuleHalfHeight ();
+	StandingCollisionShape = FCollisionShape::MakeCapsule (Capsule->GetScaledCapsuleRadius (), Capsule->GetScaledCapsuleHalfHeight ());
+	StandingMeshRelativeLocation = CharacterOwner->GetMesh () ? CharacterOwner->GetMesh ()->RelativeLocation : FVector::ZeroVector;
+}
+
+void UPlatformerPlayerMovementComp::TickComponent (float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) {
+	PLATFORMER_SCOPE_CYCLE_COUNTER (MovementTick);
+
+	CachedTimeDilation = GetWorld ()->GetWorldSettings ()->GetEffectiveTimeDilation ();
+
+	MovementLODCheckTimeLeft -= DeltaTime;
+	if (MovementLODCheckTimeLeft <= 0.0f) {
+		MovementLODCheckTimeLeft = MovementLODCheckInterval;
+		UpdateMovementLOD ();
+	}
+
+	if (bMovedByBatch) {
+		// APlatformerBatchMovementManager already moved pawn and recorded it
+		bMovedByBatch = false;
+		return;
+	}
+
+	ApplyBufferedInput ();
+
+	Super::TickComponent (DeltaTime, TickType, ThisTickFunction);
+
+	// remotely controlled pawns are recorded in MoveAutonomous
+	if (CharacterOwner && CharacterOwner->Role == ROLE_Authority && CharacterOwner->IsLocallyControlled ()) {
+		RecordMovementSnapshot (GetWorld ()->GetTimeSeconds ());
+	}
+}
+
+void UPlatformerPlayerMovementComp::ApplyBufferedInput () {
+	APlatformerCharacter* MyPawn = Cast<APlatformerCharacter> (CharacterOwner);
+	bBufferedSlide = false;
+	if (!MyPawn || !MyPawn->IsLocallyControlled ()) {
+		return;
+	}
+
+	FPlatformerInputBuffer& Input = MyPawn->GetInputBuffer ();
+	const float Now = GetWorld ()->GetTimeSeconds ();
+
+	// press may have come while pawn was in air ; jump flag travels to server with the saved move
+	// (engine's flag, APlatformerCharacter has its own bPressedJump)
+	if ((IsMovingOnGround () || IsInCoyoteTime ()) && Input.ConsumeJump (Now, JumpBufferTime)) {
+		CharacterOwner->bPressedJump = true;
+		CharacterOwner->JumpKeyHoldTime = 0.0f;
+	}
+
+	if (IsMovingOnGround () && !IsSliding () && Input.ConsumeSlide (Now, SlideBufferTime)) {
+		bBufferedSlide = true;
+	}
+}
+
+bool UPlatformerPlayerMovementComp::IsInCoyoteTime () const {
+	return IsFalling () && !bJumpedSinceGrounded && TimeSinceGrounded <= CoyoteTime;
+}
+
+bool UPlatformerPlayerMovementComp::DoJump (bool bReplayingMoves) {
+	if (!Super::DoJump (bReplayingMoves)) {
+		return false;
+	}
+
+	bJumpedSinceGrounded = true;
+	return true;
+}
+
+FNetworkPredictionData_Client* UPlatformerPlayerMovementComp::GetPredictionData_Client () const {
+	if (!ClientPredictionData) {
+		UPlatformerPlayerMovementComp* MutableThis = const_cast<UPlatformerPlayerMovementComp*> (this);
+		MutableThis->ClientPredictionData = new FNetworkPredictionData_Client_Platformer (*this);
+	}
+
+	return ClientPredictionData;
+}
+
+void UPlatformerPlayerMovementComp::UpdateFromCompressedFlags (uint8 Flags) {
+	Super::UpdateFromCompressedFlags (Flags);
+
+	APlatformerCharacter* MyPawn = Cast<APlatformerCharacter> (CharacterOwner);
+	if (!MyPawn) {
+		return;
+	}
+
+	MyPawn->SetWantsToSlide ((Flags & FSavedMove_Platformer::FLAG_WantsToSlide) != 0);
+
+	// follow client's slide state ; starting still requires slide speed
+	const bool bClientInSlide = (Flags & FSavedMove_Platformer::FLAG_InSlide) != 0;
+	if (bClientInSlide && !IsSliding ()) {
+		if (IsMovingOnGround () && Velocity.SizeSquared () > FMath::Square (MinSlideSpeed)) {
+			StartSlide ();
+		}
+	} else if (!bClientInSlide && IsSliding ()) {
+		TryToEndSlide ();
+	}
 }
 
 void UPlatformerPlayerMovementComp::StartFalling (int32 Iterations, float remainingTime, float timeTick, const FVector& Delta, const FVector& subLoc) {
@@ -41,12 +224,16 @@ void UPlatformerPlayerMovementComp::StartFalling (int32 Iterations, float remain
 //}
 
 void UPlatformerPlayerMovementComp::PhysWalking (float deltaTime, int32 Iterations) {
+	PLATFORMER_SCOPE_CYCLE_COUNTER (PhysWalking);
+
+	TimeSinceGrounded = 0.0f;
+	bJumpedSinceGrounded = false;
+
 	APlatformerCharacter* MyPawn = Cast<APlatformerCharacter> (PawnOwner);
 	if (MyPawn) {
-		const bool bWantsToSlide = MyPawn->WantsToSlide ();
+		const bool bWantsToSlide = MyPawn->WantsToSlide () || bBufferedSlide;
 		if (IsSliding ()) {
-			CalcCurrentSlideVelocityReduction (deltaTime);
-			CalcSlideVelocity (Velocity);
+			UpdateSlideVelocity (deltaTime);
 
 			const float CurrentSpeedSq = Velocity.SizeSquared ();
 			if (CurrentSpeedSq <= FMath::Square (MinSlideSpeed)) {
@@ -62,48 +249,176 @@ void UPlatformerPlayerMovementComp::PhysWalking (float deltaTime, int32 Iteratio
 		}
 	}
 
+	UpdateLookAheadSweep (deltaTime);
+	if (MovementMode != MOVE_Walking) {
+		// vault started ahead of obstacle
+		StartNewPhysics (deltaTime, Iterations);
+		return;
+	}
+
 	Super::PhysWalking (deltaTime, Iterations);
 }
 
-void UPlatformerPlayerMovementComp::CalcCurrentSlideVelocityReduction (float DeltaTime) {
-	float ReductionCoef = 0.0f;
+bool UPlatformerPlayerMovementComp::CanUseLookAheadSweep () const {
+	// remote clients report their own vaults, replayed moves must not issue queries
+	return bEnableLookAheadVault && CharacterOwner && CharacterOwner->IsLocallyControlled () && !CharacterOwner->bClientUpdating &&
+		MovementLOD == EPlatformerMovementLOD::Full && Velocity.SizeSquared2D () > FMath::Square (LookAheadMinSpeed);
+}
 
-	const float FloorDotVelocity = FVector::DotProduct (CurrentFloor.HitResult.ImpactNormal, Velocity.GetSafeNormal ());
-	const bool bNeedsSlopeAdjustment = (FloorDotVelocity != 0.0f);
+void UPlatformerPlayerMovementComp::UpdateLookAheadSweep (float DeltaTime) {
+	UWorld* World = GetWorld ();
 
-	if (bNeedsSlopeAdjustment) {
-		const float Multiplier = 1.0f + FMath::Abs<float> (FloorDotVelocity);
-		if (FloorDotVelocity > 0.0f) {
-			ReductionCoef += SlideVelocityReduction * Multiplier; // increasing speed when sliding down a slope
-		} else {
-			ReductionCoef -= SlideVelocityReduction * Multiplier; // reducing speed when sliding up a slope
+	// sweep issued last frame
+	if (LookAheadTraceHandle.IsValid ()) {
+		FTraceDatum TraceData;
+		const bool bHasData = World->QueryTraceData (LookAheadTraceHandle, TraceData);
+		LookAheadTraceHandle = FTraceHandle ();
+
+		APlatformerCharacter* MyPawn = Cast<APlatformerCharacter> (CharacterOwner);
+		if (bHasData && MyPawn && CanUseLookAheadSweep ()) {
+			const FVector MoveDir = Velocity.GetSafeNormal2D ();
+			const float MoveDist = Velocity.Size2D () * DeltaTime;
+			for (const FHitResult& Hit : TraceData.OutHits) {
+				if (!IsObstacleHit (Hit)) {
+					continue;
+				}
+
+				// vault when obstacle would be hit during this step
+				const float DistToHit = FVector::DotProduct (Hit.Location - UpdatedComponent->GetComponentLocation (), MoveDir);
+				if (DistToHit <= MoveDist) {
+					MyPawn->OnObstacleAhead (Hit);
+					return;
+				}
+			}
+		}
+	}
+
+	if (!CanUseLookAheadSweep () || LookAheadTraceFrame == GFrameCounter) {
+		return;
+	}
+	LookAheadTraceFrame = GFrameCounter;
+
+	FVector CenterOffset;
+	const FCollisionShape SweepShape = GetObstacleSweepShape (CharacterOwner->GetCapsuleComponent ()->GetScaledCapsuleHalfHeight (), CenterOffset);
+
+	const FVector Start = UpdatedComponent->GetComponentLocation () + CenterOffset;
+	const FVector End = Start + FVector (Velocity.X, Velocity.Y, 0.0f) * (DeltaTime * LookAheadFrames);
+
+	FCollisionQueryParams QueryParams (NAME_None, false, CharacterOwner);
+	FCollisionResponseParams ResponseParams;
+	InitObstacleSweepParams (QueryParams, ResponseParams);
+
+	PLATFORMER_INC_CALL_COUNTER (Traces);
+	LookAheadTraceHandle = World->AsyncSweepByChannel (EAsyncTraceType::Multi, Start, End, UpdatedPrimitive->GetCollisionObjectType (), SweepShape, QueryParams, ResponseParams);
+}
+
+FCollisionShape UPlatformerPlayerMovementComp::GetObstacleSweepShape (float CapsuleHalfHeight, FVector& OutCenterOffset) const {
+	// capsule shrunk by step height, so steps and floor don't count as obstacles
+	const float Radius = CharacterOwner->GetCapsuleComponent ()->GetScaledCapsuleRadius ();
+	const float StepHalfHeight = FMath::Max (CapsuleHalfHeight - MaxStepHeight * 0.5f, Radius);
+	OutCenterOffset = FVector (0.0f, 0.0f, CapsuleHalfHeight - StepHalfHeight);
+	return FCollisionShape::MakeCapsule (Radius, StepHalfHeight);
+}
+
+bool UPlatformerPlayerMovementComp::FindObstacleAhead (const FVector& Location, float CapsuleHalfHeight, const FVector& Direction, float Distance, FHitResult& OutHit) const {
+	if (!CharacterOwner || !UpdatedPrimitive) {
+		return false;
+	}
+
+	FVector CenterOffset;
+	const FCollisionShape SweepShape = GetObstacleSweepShape (CapsuleHalfHeight * CharacterOwner->GetCapsuleComponent ()->GetShapeScale (), CenterOffset);
+	const FVector Start = Location + CenterOffset;
+
+	FCollisionQueryParams QueryParams (TEXT ("FindObstacleAhead"), false, CharacterOwner);
+	FCollisionResponseParams ResponseParams;
+	InitObstacleSweepParams (QueryParams, ResponseParams);
+
+	PLATFORMER_INC_CALL_COUNTER (Traces);
+	TArray<FHitResult> Hits;
+	GetWorld ()->SweepMultiByChannel (Hits, Start, Start + Direction * Distance, FQuat::Identity, UpdatedPrimitive->GetCollisionObjectType (), SweepShape, QueryParams, ResponseParams);
+
+	// hits come sorted by distance
+	for (const FHitResult& Hit : Hits) {
+		if (IsObstacleHit (Hit)) {
+			OutHit = Hit;
+			return true;
 		}
-	} else {
-		ReductionCoef -= SlideVelocityReduction; // reducing speed on flat ground
 	}
 
-	float TimeDilation = GetWorld ()->GetWorldSettings ()->GetEffectiveTimeDilation ();
-	CurrentSlideVelocityReduction += (ReductionCoef * TimeDilation * DeltaTime);
+	return false;
 }
 
-void UPlatformerPlayerMovementComp::CalcSlideVelocity (FVector& OutVelocity) const {
-	const FVector VelocityDir = Velocity.GetSafeNormal ();
-	FVector NewVelocity = Velocity + CurrentSlideVelocityReduction * VelocityDir;
+void UPlatformerPlayerMovementComp::InitObstacleSweepParams (FCollisionQueryParams& QueryParams, FCollisionResponseParams& ResponseParams) const {
+	UpdatedPrimitive->InitSweepCollisionParams (QueryParams, ResponseParams);
+	ResponseParams.CollisionResponse.ReplaceChannels (ECR_Block, ECR_Overlap);
+}
+
+bool UPlatformerPlayerMovementComp::IsObstacleHit (const FHitResult& Hit) const {
+	// overlaps of geometry pawn doesn't collide with were reported too
+	const UPrimitiveComponent* Component = Hit.GetComponent ();
+	return Component && Component->GetCollisionResponseToChannel (UpdatedPrimitive->GetCollisionObjectType ()) == ECR_Block &&
+		!IsWalkable (Hit) && FVector::DotProduct (Hit.Normal, FVector::ForwardVector) < -0.9f;
+}
+
+void UPlatformerPlayerMovementComp::UpdateSlideVelocity (float DeltaTime) {
+	PLATFORMER_SCOPE_CYCLE_COUNTER (UpdateSlideVelocity);
+
+	UpdateSlideSurface ();
+	IntegrateSlide (CurrentFloor.HitResult.ImpactNormal, DeltaTime, UsesFixedSlideStep ());
+}
 
-	const float NewSpeedSq = NewVelocity.SizeSquared ();
-	if (NewSpeedSq > FMath::Square (MaxSlideSpeed)) {
-		NewVelocity = VelocityDir * MaxSlideSpeed;
-	} else if (NewSpeedSq < FMath::Square (MinSlideSpeed)) {
-		NewVelocity = VelocityDir * MinSlideSpeed;
+bool UPlatformerPlayerMovementComp::UsesFixedSlideStep () const {
+	if (MovementLOD == EPlatformerMovementLOD::Reduced) {
+		return true;
 	}
 
-	OutVelocity = NewVelocity;
+	// client predicted pawns step on both sides, so server replays client's steps whatever move lengths it receives ;
+	// AI, listen server host and simulated proxies keep per frame integration
+	return CharacterOwner && (CharacterOwner->Role == ROLE_AutonomousProxy ||
+		(CharacterOwner->Role == ROLE_Authority && CharacterOwner->IsPlayerControlled () && !CharacterOwner->IsLocallyControlled ()));
+}
+
+void UPlatformerPlayerMovementComp::IntegrateSlide (const FVector& FloorNormal, float DeltaTime, bool bFixedStep) {
+	const float ScaledDeltaTime = CachedTimeDilation * DeltaTime;
+	const float ReductionRate = SlideVelocityReduction * SlideSurfaceFrictionScale;
+	const float AccelerationRate = SlideVelocityReduction * SlideSurfaceAccelerationScale;
+
+	if (!bFixedStep || SlideFixedTimeStep <= 0.0f) {
+		FPlatformerSlideKernel::Step (Velocity, FloorNormal, ReductionRate, AccelerationRate, MinSlideSpeed, MaxSlideSpeed, ScaledDeltaTime, CurrentSlideVelocityReduction);
+		return;
+	}
+
+	// reduction accumulates every step, so long ticks are split into the steps a full rate pawn would take
+	SlideTimeAccumulator += ScaledDeltaTime;
+	while (SlideTimeAccumulator >= SlideFixedTimeStep) {
+		FPlatformerSlideKernel::Step (Velocity, FloorNormal, ReductionRate, AccelerationRate, MinSlideSpeed, MaxSlideSpeed, SlideFixedTimeStep, CurrentSlideVelocityReduction);
+		SlideTimeAccumulator -= SlideFixedTimeStep;
+	}
+}
+
+void UPlatformerPlayerMovementComp::UpdateSlideSurface () {
+	UPrimitiveComponent* FloorComponent = CurrentFloor.HitResult.GetComponent ();
+	if (SlideSurfaceComponent.Get () == FloorComponent) {
+		return;
+	}
+	SlideSurfaceComponent = FloorComponent;
+
+	// one physical material per component ; per face materials would need a query returning them every frame
+	const FBodyInstance* FloorBody = FloorComponent ? FloorComponent->GetBodyInstance () : NULL;
+	const UPlatformerPhysicalMaterial* SlideMaterial = FloorBody ? Cast<UPlatformerPhysicalMaterial> (FloorBody->GetSimplePhysicalMaterial ()) : NULL;
+
+	SlideSurfaceFrictionScale = SlideMaterial ? SlideMaterial->SlideFrictionScale : 1.0f;
+	SlideSurfaceAccelerationScale = SlideMaterial ? SlideMaterial->SlideAccelerationScale : 1.0f;
 }
 
 void UPlatformerPlayerMovementComp::StartSlide () {
 	if (!bInSlide) {
+		PLATFORMER_INC_CALL_COUNTER (SlideStarts);
+		PLATFORMER_TRACE (SlideStart, this, Velocity.Size ());
 		bInSlide = true;
 		CurrentSlideVelocityReduction = 0.0f;
+		SlideTimeAccumulator = 0.0f;
+		ClearSlideExitBlockers ();
 		SetSlideCollisionHeight ();
 
 		// handle effects when slide starts
@@ -118,6 +433,8 @@ void UPlatformerPlayerMovementComp::TryToEndSlide () {
 	// end slide if collisions allow
 	if (bInSlide) {
 		if (RestoreCollisionHeightAfterSlide ()) {
+			PLATFORMER_INC_CALL_COUNTER (SlideEnds);
+			PLATFORMER_TRACE (SlideEnd, this, Velocity.Size ());
 			bInSlide = false;
 
 			// handle effects when slide is finished
@@ -129,6 +446,34 @@ void UPlatformerPlayerMovementComp::TryToEndSlide () {
 	}
 }
 
+void UPlatformerPlayerMovementComp::ResetForRound () {
+	// snapshots and sweep results from before the restart no longer describe where pawn is
+	MovementHistory.Reset ();
+	LookAheadTraceHandle = FTraceHandle ();
+	bBufferedSlide = false;
+	TimeSinceGrounded = 0.0f;
+	bJumpedSinceGrounded = false;
+
+	// start location fits standing capsule, so no space test or height adjustment
+	if (bInSlide && CharacterOwner) {
+		PLATFORMER_TRACE (SlideEnd, this, Velocity.Size ());
+		PLATFORMER_INC_CALL_COUNTER (CapsuleResizes);
+		CharacterOwner->GetCapsuleComponent ()->SetCapsuleSize (StandingRadius, StandingHalfHeight, false);
+		if (bWantsSlideMeshRelativeLocationOffset) {
+			CharacterOwner->GetMesh ()->SetRelativeLocation (StandingMeshRelativeLocation);
+		}
+
+		APlatformerCharacter* MyOwner = Cast<APlatformerCharacter> (PawnOwner);
+		if (MyOwner) {
+			MyOwner->PlaySlideFinished ();
+		}
+	}
+	bInSlide = false;
+	CurrentSlideVelocityReduction = 0.0f;
+	SlideTimeAccumulator = 0.0f;
+	ClearSlideExitBlockers ();
+}
+
 void UPlatformerPlayerMovementComp::SetSlideCollisionHeight () {
 	if (!CharacterOwner || SlideHeight <= 0.0f) {
 		return;
@@ -139,69 +484,285 @@ void UPlatformerPlayerMovementComp::SetSlideCollisionHeight () {
 		return;
 	}
 
-	// Change collision size to new value
-	CharacterOwner->GetCapsuleComponent ()->SetCapsuleSize (CharacterOwner->GetCapsuleComponent ()->GetUnscaledCapsuleRadius (), SlideHeight);
+	// Change collision size to new value ; shape is resized in place, overlaps are refreshed by next move
+	PLATFORMER_INC_CALL_COUNTER (CapsuleResizes);
+	CharacterOwner->GetCapsuleComponent ()->SetCapsuleSize (StandingRadius, SlideHeight, false);
 
 	// applying correction to PawnOwner mesh relative location
 	if (bWantsSlideMeshRelativeLocationOffset) {
-		ACharacter* DefCharacter = CharacterOwner->GetClass ()->GetDefaultObject<ACharacter> ();
-		const FVector Correction = DefCharacter->GetMesh ()->RelativeLocation + SlideMeshRelativeLocationOffset;
-		CharacterOwner->GetMesh ()->SetRelativeLocation (Correction);
+		CharacterOwner->GetMesh ()->SetRelativeLocation (StandingMeshRelativeLocation + SlideMeshRelativeLocationOffset);
 	}
 }
 
 bool UPlatformerPlayerMovementComp::RestoreCollisionHeightAfterSlide () {
+	PLATFORMER_SCOPE_CYCLE_COUNTER (RestoreCollisionHeight);
+
 	if (!CharacterOwner || !UpdatedPrimitive) {
 		return false;
 	}
 
-	ACharacter* DefCharacter = CharacterOwner->GetClass ()->GetDefaultObject<ACharacter> ();
-	const float DefHalfHeight = DefCharacter->GetCapsuleComponent ()->GetUnscaledCapsuleHalfHeight ();
-	const float DefRadius = DefCharacter->GetCapsuleComponent ()->GetUnscaledCapsuleRadius ();
-
 	// Do not perform if collision is already at desired size.
-	if (CharacterOwner->GetCapsuleComponent ()->GetUnscaledCapsuleHalfHeight () == DefHalfHeight) {
+	if (CharacterOwner->GetCapsuleComponent ()->GetUnscaledCapsuleHalfHeight () == StandingHalfHeight) {
 		return true;
 	}
 
-	const float HeightAdjust = DefHalfHeight - CharacterOwner->GetCapsuleComponent ()->GetUnscaledCapsuleHalfHeight ();
+	const float HeightAdjust = StandingHalfHeight - CharacterOwner->GetCapsuleComponent ()->GetUnscaledCapsuleHalfHeight ();
 	const FVector NewLocation = CharacterOwner->GetActorLocation () + FVector (0.0f, 0.0f, HeightAdjust);
 
+	// geometry from previous failed test is still in the way, no need to query again
+	if (IsSlideExitStillBlocked (NewLocation, StandingRadius, StandingHalfHeight)) {
+		NumSlideExitTestsSkipped++;
+		return false;
+	}
+
 	// check if there is enough space for default capsule size
 	FCollisionQueryParams TraceParams (TEXT ("FinishSlide"), false, CharacterOwner);
 	FCollisionResponseParams ResponseParam;
 	InitCollisionParams (TraceParams, ResponseParam);
-	const bool bBlocked = GetWorld ()->OverlapBlockingTestByChannel (NewLocation, FQuat::Identity, UpdatedPrimitive->GetCollisionObjectType (), FCollisionShape::MakeCapsule (DefRadius, DefHalfHeight), TraceParams);
+	TArray<FOverlapResult>& Overlaps = SlideExitOverlaps;
+	Overlaps.Reset ();
+	bool bBlocked = false;
+	{
+		PLATFORMER_SCOPE_CYCLE_COUNTER (CollisionQuery);
+		PLATFORMER_INC_CALL_COUNTER (Overlaps);
+		bBlocked = GetWorld ()->OverlapMultiByChannel (Overlaps, NewLocation, FQuat::Identity, UpdatedPrimitive->GetCollisionObjectType (), StandingCollisionShape, TraceParams, ResponseParam);
+	}
 	if (bBlocked) {
+		// remember what blocked us, next tests will wait until pawn leaves its bounds or it moves
+		ClearSlideExitBlockers ();
+		SlideExitBlockedLocation = NewLocation;
+		for (const FOverlapResult& Overlap : Overlaps) {
+			UPrimitiveComponent* Blocker = Overlap.GetComponent ();
+			if (Overlap.bBlockingHit && Blocker) {
+				SlideExitBlockers.Add (Blocker);
+				SlideExitBlockersBounds += Blocker->Bounds.GetBox ();
+			}
+		}
 		return false;
 	}
 
-	// restore capsule size and move up to adjusted location
-	CharacterOwner->TeleportTo (NewLocation, CharacterOwner->GetActorRotation (), false, true);
-	CharacterOwner->GetCapsuleComponent ()->SetCapsuleSize (DefRadius, DefHalfHeight);
+	ClearSlideExitBlockers ();
+
+	// restore capsule size and move up to adjusted location ; space was checked above, so no sweep or teleport is needed
+	// when called from movement tick, overlaps are updated once at the end of its scoped movement update
+	PLATFORMER_INC_CALL_COUNTER (CapsuleResizes);
+	CharacterOwner->GetCapsuleComponent ()->SetCapsuleSize (StandingRadius, StandingHalfHeight, false);
+	UpdatedComponent->MoveComponent (FVector (0.0f, 0.0f, HeightAdjust), UpdatedComponent->GetComponentQuat (), false);
 
 	// restoring original PawnOwner mesh relative location
 	if (bWantsSlideMeshRelativeLocationOffset) {
-		CharacterOwner->GetMesh ()->SetRelativeLocation (DefCharacter->GetMesh ()->RelativeLocation);
+		CharacterOwner->GetMesh ()->SetRelativeLocation (StandingMeshRelativeLocation);
 	}
 
 	return true;
 }
 
-void UPlatformerPlayerMovementComp::PauseMovementForObstacleHit () {
-	SavedSpeed = Velocity.Size () * ModSpeedObstacleHit;
+bool UPlatformerPlayerMovementComp::IsSlideExitStillBlocked (const FVector& Location, float Radius, float HalfHeight) const {
+	if (SlideExitBlockers.Num () == 0 || NumSlideExitTestsSkipped >= MaxSlideExitTestsSkipped) {
+		return false;
+	}
+
+	// blocker bounds may cover far more than the part that was in the way
+	if (FVector::DistSquared (Location, SlideExitBlockedLocation) > FMath::Square (Radius)) {
+		return false;
+	}
+
+	// any blocker destroyed or moved - test again
+	FBox CurrentBounds (ForceInit);
+	for (const TWeakObjectPtr<UPrimitiveComponent>& Blocker : SlideExitBlockers) {
+		if (!Blocker.IsValid ()) {
+			return false;
+		}
+		CurrentBounds += Blocker->Bounds.GetBox ();
+	}
+
+	if (!CurrentBounds.Min.Equals (SlideExitBlockersBounds.Min) || !CurrentBounds.Max.Equals (SlideExitBlockersBounds.Max)) {
+		return false;
+	}
+
+	const FVector CapsuleExtent (Radius, Radius, HalfHeight);
+	return SlideExitBlockersBounds.Intersect (FBox (Location - CapsuleExtent, Location + CapsuleExtent));
+}
+
+void UPlatformerPlayerMovementComp::ClearSlideExitBlockers () {
+	SlideExitBlockers.Reset ();
+	SlideExitBlockersBounds.Init ();
+	NumSlideExitTestsSkipped = 0;
+}
+
+void UPlatformerPlayerMovementComp::StartVault (UPrimitiveComponent* Obstacle, float HitReactionTime, bool bLookAhead) {
+	if (IsVaulting ()) {
+		return;
+	}
+
+	SavedSpeed = Velocity.Size () * (bLookAhead ? ModSpeedLookAheadVault : ModSpeedObstacleHit);
+	LookAheadTraceHandle = FTraceHandle ();
 
 	StopMovementImmediately ();
-	DisableMovement ();
 	TryToEndSlide ();
+
+	// pawn keeps colliding with everything except the obstacle it climbs over ; only the component is ignored,
+	// merged or level wide actors own unrelated geometry too
+	if (Obstacle && UpdatedPrimitive) {
+		UpdatedPrimitive->IgnoreComponentWhenMoving (Obstacle, true);
+		VaultIgnoredComponent = Obstacle;
+	}
+
+	SetMovementMode (MOVE_Custom, (uint8)EPlatformerCustomMovementMode::Vault);
+	VaultState = EPlatformerVaultState::HitReaction;
+	VaultStateTimeLeft = HitReactionTime;
+
+	if (HitReactionTime <= 0.0f) {
+		StartVaultClimb ();
+	}
+}
+
+bool UPlatformerPlayerMovementComp::IsVaulting () const {
+	return MovementMode == MOVE_Custom && CustomMovementMode == (uint8)EPlatformerCustomMovementMode::Vault;
+}
+
+void UPlatformerPlayerMovementComp::PhysCustom (float deltaTime, int32 Iterations) {
+	if (CustomMovementMode == (uint8)EPlatformerCustomMovementMode::Vault) {
+		PhysVault (deltaTime, Iterations);
+		return;
+	}
+
+	Super::PhysCustom (deltaTime, Iterations);
+}
+
+void UPlatformerPlayerMovementComp::OnMovementModeChanged (EMovementMode PreviousMovementMode, uint8 PreviousCustomMode) {
+	Super::OnMovementModeChanged (PreviousMovementMode, PreviousCustomMode);
+
+	const bool bWasVaulting = (PreviousMovementMode == MOVE_Custom && PreviousCustomMode == (uint8)EPlatformerCustomMovementMode::Vault);
+	if (bWasVaulting && !IsVaulting ()) {
+		VaultState = EPlatformerVaultState::None;
+		if (VaultIgnoredComponent.IsValid () && UpdatedPrimitive) {
+			UpdatedPrimitive->IgnoreComponentWhenMoving (VaultIgnoredComponent.Get (), false);
+		}
+		VaultIgnoredComponent.Reset ();
+	}
+}
+
+void UPlatformerPlayerMovementComp::PhysVault (float deltaTime, int32 Iterations) {
+	VaultStateTimeLeft -= deltaTime;
+
+	switch (VaultState) {
+		case EPlatformerVaultState::HitReaction:
+			Velocity = FVector::ZeroVector;
+			if (VaultStateTimeLeft <= 0.0f) {
+				StartVaultClimb ();
+			}
+			break;
+
+		case EPlatformerVaultState::Climb:
+			if (VaultStateTimeLeft <= 0.0f) {
+				FinishVault ();
+				break;
+			}
+
+			// velocity comes from climb animation root motion, including Z
+			if (!Velocity.IsZero ()) {
+				const FVector Delta = Velocity * deltaTime;
+				FHitResult Hit (1.0f);
+				SafeMoveUpdatedComponent (Delta, UpdatedComponent->GetComponentQuat (), true, Hit);
+				if (Hit.IsValidBlockingHit ()) {
+					SlideAlongSurface (Delta, 1.0f - Hit.Time, Hit.Normal, Hit, true);
+				}
+			}
+			break;
+
+		case EPlatformerVaultState::LedgeClimb:
+			// pawn already stands on ledge, climb animation only catches up with it
+			Velocity = FVector::ZeroVector;
+			if (VaultStateTimeLeft <= 0.0f) {
+				FinishVault ();
+			}
+			break;
+
+		default:
+			FinishVault ();
+			break;
+	}
 }
 
-void UPlatformerPlayerMovementComp::PauseMovementForLedgeGrab () {
+void UPlatformerPlayerMovementComp::StartVaultClimb () {
+	APlatformerCharacter* MyPawn = Cast<APlatformerCharacter> (CharacterOwner);
+	const float Duration = MyPawn ? MyPawn->ClimbOverObstacle () : 0.0f;
+	if (Duration <= 0.0f) {
+		// shouldn't happen
+		FinishVault ();
+		return;
+	}
+
+	VaultState = EPlatformerVaultState::Climb;
+	VaultStateTimeLeft = Duration - VaultClimbEndTime;
+}
+
+void UPlatformerPlayerMovementComp::FinishVault () {
+	APlatformerCharacter* MyPawn = Cast<APlatformerCharacter> (CharacterOwner);
+	if (MyPawn) {
+		MyPawn->ResumeMovement ();
+	} else {
+		RestoreMovement ();
+	}
+}
+
+void UPlatformerPlayerMovementComp::PhysFalling (float deltaTime, int32 Iterations) {
+	TimeSinceGrounded += deltaTime;
+
+	// rising jumps don't snap to ledges
+	APlatformerClimbMarker* Marker = (Velocity.Z <= 0.0f) ? FindLedgeInReach () : NULL;
+	if (Marker) {
+		StartLedgeGrab (Marker);
+		if (IsVaulting ()) {
+			return;
+		}
+	}
+
+	Super::PhysFalling (deltaTime, Iterations);
+}
+
+APlatformerClimbMarker* UPlatformerPlayerMovementComp::FindLedgeInReach () const {
+	if (!ClimbMarkerRegistry.IsValid () || !CharacterOwner) {
+		return NULL;
+	}
+
+	const UCapsuleComponent* Capsule = CharacterOwner->GetCapsuleComponent ();
+	const float Radius = Capsule->GetScaledCapsuleRadius ();
+	const float HalfHeight = Capsule->GetScaledCapsuleHalfHeight ();
+	const FVector Location = UpdatedComponent->GetComponentLocation ();
+
+	// hands reach from chest height to above head, in front of pawn running along X
+	const FBox GrabBounds (
+		FVector (Location.X, Location.Y - Radius, Location.Z),
+		FVector (Location.X + Radius + LedgeGrabReachForward, Location.Y + Radius, Location.Z + HalfHeight + LedgeGrabReachUp));
+
+	return ClimbMarkerRegistry->FindLedge (GrabBounds);
+}
+
+void UPlatformerPlayerMovementComp::StartLedgeGrab (APlatformerClimbMarker* Marker) {
+	// checked before touching movement state, a pawn that can't climb keeps falling untouched
+	APlatformerCharacter* MyPawn = Cast<APlatformerCharacter> (CharacterOwner);
+	if (IsVaulting () || !MyPawn || !MyPawn->CanClimbToLedge (Marker)) {
+		return;
+	}
+
+	const FVector FallVelocity = Velocity;
 	SavedSpeed = Velocity.Size () * ModSpeedLedgeGrab;
 
 	StopMovementImmediately ();
-	DisableMovement ();
-	TryToEndSlide ();
+	SetMovementMode (MOVE_Custom, (uint8)EPlatformerCustomMovementMode::Vault);
+	VaultState = EPlatformerVaultState::LedgeClimb;
+
+	const float Duration = MyPawn->ClimbToLedge (Marker);
+	if (Duration <= 0.0f) {
+		// montage failed to play, keep falling
+		SetMovementMode (MOVE_Falling);
+		Velocity = FallVelocity;
+		return;
+	}
+
+	VaultStateTimeLeft = Duration - VaultClimbEndTime;
 }
 
 void UPlatformerPlayerMovementComp::RestoreMovement () {
@@ -210,8 +771,396 @@ void UPlatformerPlayerMovementComp::RestoreMovement () {
 	if (SavedSpeed > 0) {
 		Velocity = PawnOwner->GetActorForwardVector () * SavedSpeed;
 	}
+
+	PLATFORMER_TRACE (Resume, this, Velocity.Size ());
+}
+
+EPlatformerMovementLOD UPlatformerPlayerMovementComp::GetMovementLOD () const {
+	return MovementLOD;
+}
+
+void UPlatformerPlayerMovementComp::UpdateMovementLOD () {
+	// players always simulate at full rate
+	if (!bEnableMovementLOD || !CharacterOwner || CharacterOwner->IsPlayerControlled ()) {
+		SetMovementLOD (EPlatformerMovementLOD::Full);
+		return;
+	}
+
+	const FVector Location = CharacterOwner->GetActorLocation ();
+	float MinViewDistSq = MAX_FLT;
+	for (FConstPlayerControllerIterator Iterator = GetWorld ()->GetPlayerControllerIterator (); Iterator; ++Iterator) {
+		APlayerController* PlayerController = Iterator->Get ();
+		if (PlayerController) {
+			FVector ViewLocation;
+			FRotator ViewRotation;
+			PlayerController->GetPlayerViewPoint (ViewLocation, ViewRotation);
+			MinViewDistSq = FMath::Min (MinViewDistSq, FVector::DistSquared (Location, ViewLocation));
+		}
+	}
+
+	const bool bFar = MinViewDistSq > FMath::Square (ReducedLODDistance);
+
+	// dedicated server doesn't render, distance is all it has
+	const bool bNotRendered = GetNetMode () != NM_DedicatedServer &&
+		GetWorld ()->GetTimeSeconds () - CharacterOwner->GetLastRenderTime () > ReducedLODNotRenderedTime;
+
+	SetMovementLOD ((bFar || bNotRendered) ? EPlatformerMovementLOD::Reduced : EPlatformerMovementLOD::Full);
+}
+
+void UPlatformerPlayerMovementComp::SetMovementLOD (EPlatformerMovementLOD NewLOD) {
+	if (MovementLOD != NewLOD) {
+		MovementLOD = NewLOD;
+		SlideTimeAccumulator = 0.0f;
+		PrimaryComponentTick.TickInterval = (NewLOD == EPlatformerMovementLOD::Reduced) ? ReducedLODTickInterval : 0.0f;
+	}
+}
+
+void UPlatformerPlayerMovementComp::MoveAutonomous (float ClientTimeStamp, float DeltaTime, uint8 CompressedFlags, const FVector& NewAccel) {
+	Super::MoveAutonomous (ClientTimeStamp, DeltaTime, CompressedFlags, NewAccel);
+
+	RecordMovementSnapshot (ClientTimeStamp);
+
+	APlatformerCharacter* MyPawn = Cast<APlatformerCharacter> (CharacterOwner);
+	if (MyPawn) {
+		MyPawn->OnClientMoveProcessed (ClientTimeStamp);
+	}
+}
+
+void UPlatformerPlayerMovementComp::RecordMovementSnapshot (float Timestamp) {
+	if (!CharacterOwner) {
+		return;
+	}
+
+	if (!MovementHistory.IsInitialized ()) {
+		MovementHistory.Init (MovementHistorySize);
+	}
+
+	FPlatformerMovementSnapshot Snapshot;
+	Snapshot.Timestamp = Timestamp;
+	Snapshot.Location = CharacterOwner->GetActorLocation ();
+	Snapshot.Velocity = Velocity;
+	Snapshot.CapsuleHalfHeight = CharacterOwner->GetCapsuleComponent ()->GetUnscaledCapsuleHalfHeight ();
+	Snapshot.MovementMode = MovementMode;
+	Snapshot.bSliding = bInSlide;
+	MovementHistory.Record (Snapshot);
+}
+
+bool UPlatformerPlayerMovementComp::GetMovementSnapshot (float Timestamp, FPlatformerMovementSnapshot& OutSnapshot) const {
+	return MovementHistory.Sample (Timestamp, OutSnapshot);
+}
+
+bool UPlatformerPlayerMovementComp::IsClientMoveAhead (float ClientTimeStamp) const {
+	return MovementHistory.IsAfterNewest (ClientTimeStamp);
+}
+
+float UPlatformerPlayerMovementComp::GetClientMoveTimeStamp () const {
+	const FNetworkPredictionData_Client_Character* ClientData = GetPredictionData_Client_Character ();
+	return ClientData ? ClientData->CurrentTimeStamp : 0.0f;
+}
+
+void UPlatformerPlayerMovementComp::SetUseBatchMovement (bool bUse) {
+	bUseBatchMovement = bUse;
+
+	if (BatchMovementManager.IsValid ()) {
+		BatchMovementManager->UnregisterMovement (this);
+		BatchMovementManager.Reset ();
+	}
+
+	if (bUseBatchMovement && HasBegunPlay ()) {
+		BatchMovementManager = APlatformerBatchMovementManager::Get (GetWorld ());
+		if (BatchMovementManager.IsValid ()) {
+			BatchMovementManager->RegisterMovement (this);
+		}
+	}
+}
+
+void UPlatformerPlayerMovementComp::SetMovementLODEnabled (bool bEnable) {
+	bEnableMovementLOD = bEnable;
+
+	if (!bEnableMovementLOD) {
+		SetMovementLOD (EPlatformerMovementLOD::Full);
+	}
+}
+
+bool UPlatformerPlayerMovementComp::CanUseBatchMovement () const {
+	// players, jumps, root motion and based movement need full movement tick
+	// avoidance velocity reads and writes world's avoidance manager, which isn't safe on worker threads
+	return CharacterOwner && UpdatedComponent && IsActive () && MovementMode == MOVE_Walking && !bUseRVOAvoidance &&
+		CharacterOwner->Role == ROLE_Authority && !CharacterOwner->IsPlayerControlled () && !CharacterOwner->bPressedJump &&
+		MovementLOD == EPlatformerMovementLOD::Full && !HasAnimRootMotion () && !UpdatedComponent->IsSimulatingPhysics () &&
+		CurrentFloor.IsWalkableFloor () && !MovementBaseUtility::IsDynamicBase (CharacterOwner->GetMovementBase ());
+}
+
+void UPlatformerPlayerMovementComp::PrepareBatchMove (float DeltaTime, FPlatformerBatchMove& Move) {
+	CachedTimeDilation = GetWorld ()->GetWorldSettings ()->GetEffectiveTimeDilation ();
+
+	// same as ControlledCharacterMove, skipped by batched pawns
+	Acceleration = ScaleInputAcceleration (ConstrainInputAcceleration (ConsumeInputVector ()));
+	Acceleration.Z = 0.0f;
+	AnalogInputModifier = ComputeAnalogInputModifier ();
+
+	// slide start resizes capsule and surface lookup reads floor's material, both stay on game thread
+	APlatformerCharacter* MyPawn = Cast<APlatformerCharacter> (CharacterOwner);
+	if (!IsSliding () && MyPawn && MyPawn->WantsToSlide () &&
+		Velocity.SizeSquared () > FMath::Square (MinSlideSpeed * 2.0f))
+	{
+		StartSlide ();
+	}
+	if (IsSliding ()) {
+		UpdateSlideSurface ();
+	}
+
+	const UCapsuleComponent* Capsule = CharacterOwner->GetCapsuleComponent ();
+	const float Radius = Capsule->GetScaledCapsuleRadius ();
+	const float HalfHeight = Capsule->GetScaledCapsuleHalfHeight ();
+
+	Move.Movement = this;
+	Move.World = GetWorld ();
+	Move.DeltaTime = DeltaTime;
+	Move.StartLocation = UpdatedComponent->GetComponentLocation ();
+	Move.StartVelocity = Velocity;
+	Move.Shape = FCollisionShape::MakeCapsule (Radius, HalfHeight);
+	Move.FloorShape = FCollisionShape::MakeCapsule (Radius * 0.9f, HalfHeight);
+	Move.Channel = UpdatedPrimitive->GetCollisionObjectType ();
+	Move.QueryParams = FCollisionQueryParams (TEXT ("BatchMove"), false, CharacterOwner);
+	Move.ResponseParams = FCollisionResponseParams ();
+	InitCollisionParams (Move.QueryParams, Move.ResponseParams);
+	Move.bFixedSlideStep = UsesFixedSlideStep ();
+
+	Move.EndLocation = Move.StartLocation;
+	Move.FloorDist = 0.0f;
+	Move.NumTraces = 0;
+	Move.bBlocked = false;
+	Move.bFoundFloor = false;
+	Move.bStepUp = false;
+}
+
+void UPlatformerPlayerMovementComp::SimulateBatchMove (FPlatformerBatchMove& Move) {
+	const float DeltaTime = Move.DeltaTime;
+	const FVector FloorNormal = CurrentFloor.HitResult.ImpactNormal;
+
+	// velocity as in PhysWalking
+	if (bInSlide) {
+		IntegrateSlide (FloorNormal, DeltaTime, Move.bFixedSlideStep);
+	}
+	Velocity.Z = 0.0f;
+	CalcVelocity (DeltaTime, GroundFriction, false, GetMaxBrakingDeceleration ());
+
+	// move along floor ramp, sliding along anything blocking
+	FVector Delta = Velocity * DeltaTime;
+	if (FloorNormal.Z > KINDA_SMALL_NUMBER) {
+		Delta.Z = -FVector::DotProduct (FloorNormal, FVector (Delta.X, Delta.Y, 0.0f)) / FloorNormal.Z;
+	}
+
+	FVector Location = Move.StartLocation;
+	for (int32 Iteration = 0; Iteration < 2 && !Delta.IsNearlyZero (); Iteration++) {
+		FHitResult Hit;
+		Move.NumTraces++;
+		if (!Move.World->SweepSingleByChannel (Hit, Location, Location + Delta, FQuat::Identity, Move.Channel, Move.Shape, Move.QueryParams, Move.ResponseParams)) {
+			Location += Delta;
+			break;
+		}
+
+		if (Hit.bStartPenetrating) {
+			// leave depenetration to regular movement, next frame pawn isn't on a valid floor
+			break;
+		}
+
+		Location = Hit.Location;
+		if (!Move.bBlocked) {
+			Move.BlockingHit = Hit;
+			Move.bBlocked = true;
+		}
+
+		// step up sweeps and tests hit component, left to game thread
+		if (!IsWalkable (Hit) && Hit.ImpactPoint.Z - (Location.Z - Move.Shape.GetCapsuleHalfHeight ()) <= MaxStepHeight) {
+			Move.BlockingHit = Hit;
+			Move.StepUpDelta = Delta * (1.0f - Hit.Time);
+			Move.bStepUp = true;
+			break;
+		}
+
+		Delta = FVector::VectorPlaneProject (Delta * (1.0f - Hit.Time), Hit.Normal);
+	}
+
+	// floor within step height below pawn
+	const float FloorSweepDist = MaxStepHeight + MAX_FLOOR_DIST;
+	Move.NumTraces++;
+	Move.bFoundFloor = Move.World->SweepSingleByChannel (Move.FloorHit, Location, Location - FVector (0.0f, 0.0f, FloorSweepDist), FQuat::Identity, Move.Channel, Move.FloorShape, Move.QueryParams, Move.ResponseParams) &&
+		!Move.FloorHit.bStartPenetrating && IsWalkable (Move.FloorHit);
+	if (Move.bFoundFloor) {
+		Move.FloorDist = (MIN_FLOOR_DIST + MAX_FLOOR_DIST) * 0.5f;
+		Location.Z = Move.FloorHit.Location.Z + Move.FloorDist;
+	}
+
+	// velocity reflects actual move
+	Velocity = (Location - Move.StartLocation) / DeltaTime;
+	Velocity.Z = 0.0f;
+	Move.EndLocation = Location;
+}
+
+void UPlatformerPlayerMovementComp::ApplyBatchMove (const FPlatformerBatchMove& Move) {
+	PLATFORMER_ADD_CALL_COUNTER (Traces, Move.NumTraces);
+
+	// batch swept against start locations of other pawns ; final sweep keeps pawns moved by it from ending up inside each other
+	FHitResult PawnHit;
+	PLATFORMER_INC_CALL_COUNTER (Traces);
+	SafeMoveUpdatedComponent (Move.EndLocation - UpdatedComponent->GetComponentLocation (), UpdatedComponent->GetComponentQuat (), true, PawnHit);
+	bMovedByBatch = true;
+
+	// same as MoveAlongFloor: step that can't be climbed is an impact
+	FStepDownResult StepDownResult;
+	const bool bSteppedUp = Move.bStepUp && !PawnHit.bBlockingHit && CanStepUp (Move.BlockingHit) &&
+		StepUp (-FVector::UpVector, Move.StepUpDelta, Move.BlockingHit, &StepDownResult);
+
+	// obstacle hits start vault through MoveBlockedBy
+	if (Move.bBlocked && !bSteppedUp) {
+		HandleImpact (Move.BlockingHit, Move.DeltaTime, Move.EndLocation - Move.StartLocation);
+	} else if (PawnHit.bBlockingHit) {
+		HandleImpact (PawnHit, Move.DeltaTime, Move.EndLocation - Move.StartLocation);
+	}
+
+	if (PawnHit.bBlockingHit || bSteppedUp) {
+		Velocity = (UpdatedComponent->GetComponentLocation () - Move.StartLocation) / Move.DeltaTime;
+		Velocity.Z = 0.0f;
+	}
+
+	if (bSteppedUp && MovementMode == MOVE_Walking) {
+		if (StepDownResult.bComputedFloor) {
+			CurrentFloor = StepDownResult.FloorResult;
+		} else {
+			FindFloor (UpdatedComponent->GetComponentLocation (), CurrentFloor, false);
+		}
+
+		if (CurrentFloor.IsWalkableFloor ()) {
+			SetBaseFromFloor (CurrentFloor);
+		} else {
+			SetMovementMode (MOVE_Falling);
+		}
+	} else if (MovementMode == MOVE_Walking) {
+		if (Move.bFoundFloor) {
+			CurrentFloor.SetFromSweep (Move.FloorHit, Move.FloorDist, true);
+			SetBaseFromFloor (CurrentFloor);
+		} else {
+			// regular movement takes over while falling
+			SetMovementMode (MOVE_Falling);
+		}
+	}
+
+	if (IsSliding () && Velocity.SizeSquared () <= FMath::Square (MinSlideSpeed)) {
+		TryToEndSlide ();
+	}
+
+	// rest of PerformMovement: rotation and movement updated notifies
+	PhysicsRotation (Move.DeltaTime);
+	UpdateComponentVelocity ();
+	OnMovementUpdated (Move.DeltaTime, Move.StartLocation, Move.StartVelocity);
+	CharacterOwner->OnCharacterMovementUpdated.Broadcast (Move.DeltaTime, Move.StartLocation, Move.StartVelocity);
+
+	RecordMovementSnapshot (GetWorld ()->GetTimeSeconds ());
 }
 
 bool UPlatformerPlayerMovementComp::IsSliding () const {
 	return bInSlide;
 };
+
+FSavedMove_Platformer::FSavedMove_Platformer () {
+	Clear ();
+}
+
+void FSavedMove_Platformer::Clear () {
+	Super::Clear ();
+
+	bWantsToSlide = false;
+	bBufferedSlide = false;
+	bStartInSlide = false;
+	StartSlideVelocityReduction = 0.0f;
+	StartSlideTimeAccumulator = 0.0f;
+}
+
+uint8 FSavedMove_Platformer::GetCompressedFlags () const {
+	uint8 Result = Super::GetCompressedFlags ();
+
+	if (bWantsToSlide || bBufferedSlide) {
+		Result |= FLAG_WantsToSlide;
+	}
+	if (bStartInSlide) {
+		Result |= FLAG_InSlide;
+	}
+
+	return Result;
+}
+
+bool FSavedMove_Platformer::CanCombineWith (const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const {
+	// consecutive slide moves combine fine, slide input or state changes don't
+	const FSavedMove_Platformer* NewPlatformerMove = static_cast<const FSavedMove_Platformer*> (NewMove.Get ());
+	if (bWantsToSlide != NewPlatformerMove->bWantsToSlide || bBufferedSlide != NewPlatformerMove->bBufferedSlide || bStartInSlide != NewPlatformerMove->bStartInSlide) {
+		return false;
+	}
+
+	// fixed slide steps run before a move's movement ; steps new move would finish follow this move's movement,
+	// merged they would run before it, so new move can only be merged if it doesn't finish a step
+	const UPlatformerPlayerMovementComp* MoveComp = Cast<UPlatformerPlayerMovementComp> (InCharacter->GetCharacterMovement ());
+	if (bStartInSlide && MoveComp && MoveComp->UsesFixedSlideStep () &&
+		NewPlatformerMove->StartSlideTimeAccumulator + NewPlatformerMove->DeltaTime * MoveComp->CachedTimeDilation >= MoveComp->SlideFixedTimeStep)
+	{
+		return false;
+	}
+
+	return Super::CanCombineWith (NewMove, InCharacter, MaxDelta);
+}
+
+void FSavedMove_Platformer::SetMoveFor (ACharacter* Character, float InDeltaTime, FVector const& NewAccel, FNetworkPredictionData_Client_Character& ClientData) {
+	Super::SetMoveFor (Character, InDeltaTime, NewAccel, ClientData);
+
+	APlatformerCharacter* MyPawn = Cast<APlatformerCharacter> (Character);
+	bWantsToSlide = MyPawn && MyPawn->WantsToSlide ();
+
+	const UPlatformerPlayerMovementComp* MoveComp = Cast<UPlatformerPlayerMovementComp> (Character->GetCharacterMovement ());
+	bBufferedSlide = MoveComp && MoveComp->bBufferedSlide;
+}
+
+void FSavedMove_Platformer::SetInitialPosition (ACharacter* Character) {
+	Super::SetInitialPosition (Character);
+
+	const UPlatformerPlayerMovementComp* MoveComp = Cast<UPlatformerPlayerMovementComp> (Character->GetCharacterMovement ());
+	if (MoveComp) {
+		bStartInSlide = MoveComp->bInSlide;
+		StartSlideVelocityReduction = MoveComp->CurrentSlideVelocityReduction;
+		StartSlideTimeAccumulator = MoveComp->SlideTimeAccumulator;
+	}
+}
+
+void FSavedMove_Platformer::PrepMoveFor (ACharacter* Character) {
+	Super::PrepMoveFor (Character);
+
+	// replaying after correction: start from slide state client had for this move, whatever state correction left
+	// compressed flags then match current state, so replay doesn't restart slide and reset its integration
+	UPlatformerPlayerMovementComp* MoveComp = Cast<UPlatformerPlayerMovementComp> (Character->GetCharacterMovement ());
+	if (!MoveComp) {
+		return;
+	}
+
+	// slide effects already played when move was first simulated
+	if (bStartInSlide && !MoveComp->bInSlide) {
+		MoveComp->bInSlide = true;
+		MoveComp->ClearSlideExitBlockers ();
+		MoveComp->SetSlideCollisionHeight ();
+	} else if (!bStartInSlide && MoveComp->bInSlide && MoveComp->RestoreCollisionHeightAfterSlide ()) {
+		MoveComp->bInSlide = false;
+	}
+
+	MoveComp->CurrentSlideVelocityReduction = StartSlideVelocityReduction;
+	MoveComp->SlideTimeAccumulator = StartSlideTimeAccumulator;
+
+	// buffered press is consumed once, replayed moves only see it if it was consumed for them
+	MoveComp->bBufferedSlide = bBufferedSlide;
+}
+
+FNetworkPredictionData_Client_Platformer::FNetworkPredictionData_Client_Platformer (const UCharacterMovementComponent& ClientMovement)
+	: Super (ClientMovement) {
+}
+
+FSavedMovePtr FNetworkPredictionData_Client_Platformer::AllocateNewMove () {
+	return FSavedMovePtr (new FSavedMove_Platformer ());
+}
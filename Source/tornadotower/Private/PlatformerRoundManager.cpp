@@ -0,0 +1,145 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "tornadotower.h"
+#include "../Public/PlatformerRoundManager.h"
+#include "../Public/PlatformerCharacter.h"
+#include "../Public/PlatformerGhostManager.h"
+
+APlatformerRoundManager::APlatformerRoundManager (const FObjectInitializer& ObjectInitializer)
+	: Super (ObjectInitializer) {
+	RoundState = EPlatformerRoundState::Waiting;
+	RoundStartTime = 0.0f;
+	RoundFinishTime = 0.0f;
+	bRoundWon = false;
+}
+
+APlatformerRoundManager* APlatformerRoundManager::Get (UWorld* World) {
+	if (!World || !World->IsGameWorld () || World->GetNetMode () == NM_Client) {
+		return nullptr;
+	}
+
+	for (TActorIterator<APlatformerRoundManager> It (World); It; ++It) {
+		return *It;
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	return World->SpawnActor<APlatformerRoundManager> (SpawnParams);
+}
+
+void APlatformerRoundManager::StartRound () {
+	if (RoundState == EPlatformerRoundState::Waiting) {
+		TakeSnapshot ();
+	}
+
+	RoundState = EPlatformerRoundState::Playing;
+	RoundStartTime = GetWorld ()->GetTimeSeconds ();
+	bRoundWon = false;
+
+	APlatformerGhostManager* GhostManager = APlatformerGhostManager::Get (GetWorld ());
+	if (GhostManager) {
+		GhostManager->StartRun (Cast<APlatformerCharacter> (UGameplayStatics::GetPlayerCharacter (this, 0)));
+	}
+}
+
+void APlatformerRoundManager::FinishRound (bool bWon) {
+	if (RoundState != EPlatformerRoundState::Playing) {
+		return;
+	}
+
+	RoundState = EPlatformerRoundState::Finished;
+	RoundFinishTime = GetWorld ()->GetTimeSeconds ();
+	bRoundWon = bWon;
+
+	APlatformerGhostManager* GhostManager = APlatformerGhostManager::Get (GetWorld ());
+	if (GhostManager) {
+		GhostManager->FinishRun (bWon);
+	}
+
+	for (TActorIterator<APlatformerCharacter> It (GetWorld ()); It; ++It) {
+		It->OnRoundFinished ();
+	}
+}
+
+bool APlatformerRoundManager::TryRestartRound () {
+	if (RoundState == EPlatformerRoundState::Waiting) {
+		return false;
+	}
+
+	RestoreSnapshot ();
+	StartRound ();
+	return true;
+}
+
+float APlatformerRoundManager::GetRoundTime () const {
+	switch (RoundState) {
+		case EPlatformerRoundState::Playing:
+			return GetWorld ()->GetTimeSeconds () - RoundStartTime;
+
+		case EPlatformerRoundState::Finished:
+			return RoundFinishTime - RoundStartTime;
+
+		default:
+			return 0.0f;
+	}
+}
+
+void APlatformerRoundManager::TakeSnapshot () {
+	Snapshot.Reset ();
+
+	for (FActorIterator It (GetWorld ()); It; ++It) {
+		AActor* Actor = *It;
+		APlatformerCharacter* Character = Cast<APlatformerCharacter> (Actor);
+		UPrimitiveComponent* Root = Cast<UPrimitiveComponent> (Actor->GetRootComponent ());
+
+		// characters and anything else that can move: moving platforms, physics props
+		const bool bDynamicObstacle = !Character && Root && Root->Mobility == EComponentMobility::Movable && !Actor->IsA<APawn> ();
+		if (!Character && !bDynamicObstacle) {
+			continue;
+		}
+
+		FPlatformerRoundActorState& State = Snapshot[Snapshot.AddUninitialized ()];
+		State.Actor = Actor;
+		State.Location = Actor->GetActorLocation ();
+		State.Rotation = Actor->GetActorQuat ();
+		State.AngularVelocity = FVector::ZeroVector;
+		State.ControlRotation = FRotator::ZeroRotator;
+		State.bCharacter = (Character != NULL);
+
+		if (Character) {
+			State.LinearVelocity = Character->GetCharacterMovement ()->Velocity;
+			State.ControlRotation = Character->Controller ? Character->Controller->GetControlRotation () : Character->GetActorRotation ();
+		} else if (Root->IsSimulatingPhysics ()) {
+			State.LinearVelocity = Root->GetPhysicsLinearVelocity ();
+			State.AngularVelocity = Root->GetPhysicsAngularVelocity ();
+		} else {
+			State.LinearVelocity = FVector::ZeroVector;
+		}
+	}
+}
+
+void APlatformerRoundManager::RestoreSnapshot () {
+	for (const FPlatformerRoundActorState& State : Snapshot) {
+		AActor* Actor = State.Actor.Get ();
+		if (!Actor) {
+			continue;
+		}
+
+		Actor->SetActorLocationAndRotation (State.Location, State.Rotation, false, nullptr, ETeleportType::TeleportPhysics);
+
+		if (State.bCharacter) {
+			APlatformerCharacter* Character = static_cast<APlatformerCharacter*> (Actor);
+			Character->OnRoundReset ();
+			Character->GetCharacterMovement ()->Velocity = State.LinearVelocity;
+			if (Character->Controller) {
+				Character->Controller->SetControlRotation (State.ControlRotation);
+			}
+		} else {
+			UPrimitiveComponent* Root = Cast<UPrimitiveComponent> (Actor->GetRootComponent ());
+			if (Root && Root->IsSimulatingPhysics ()) {
+				Root->SetPhysicsLinearVelocity (State.LinearVelocity);
+				Root->SetPhysicsAngularVelocity (State.AngularVelocity);
+			}
+		}
+	}
+}
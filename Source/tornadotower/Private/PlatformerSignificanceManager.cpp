@@ -0,0 +1,123 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "tornadotower.h"
+#include "../Public/PlatformerSignificanceManager.h"
+#include "../Public/PlatformerCharacter.h"
+
+APlatformerSignificanceManager::APlatformerSignificanceManager (const FObjectInitializer& ObjectInitializer)
+	: Super (ObjectInitializer) {
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.TickGroup = TG_PrePhysics;
+
+	UpdateInterval = 0.25f;
+	MaxDistance = 5000.0f;
+	NotRenderedTime = 0.5f;
+	NotRenderedScoreScale = 0.25f;
+	HighScore = 0.6f;
+	MediumScore = 0.25f;
+	MediumAnimTickInterval = 1.0f / 30.0f;
+	LowActorTickInterval = 0.2f;
+	LowAnimTickInterval = 0.1f;
+
+	UpdateTimeLeft = 0.0f;
+}
+
+APlatformerSignificanceManager* APlatformerSignificanceManager::Get (UWorld* World) {
+	if (!World || !World->IsGameWorld ()) {
+		return nullptr;
+	}
+
+	for (TActorIterator<APlatformerSignificanceManager> It (World); It; ++It) {
+		return *It;
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	return World->SpawnActor<APlatformerSignificanceManager> (SpawnParams);
+}
+
+void APlatformerSignificanceManager::RegisterCharacter (APlatformerCharacter* Character) {
+	Characters.AddUnique (Character);
+}
+
+void APlatformerSignificanceManager::UnregisterCharacter (APlatformerCharacter* Character) {
+	Characters.RemoveSingleSwap (Character);
+	Character->SetSignificance (EPlatformerSignificance::High);
+}
+
+void APlatformerSignificanceManager::Tick (float DeltaSeconds) {
+	Super::Tick (DeltaSeconds);
+
+	UpdateTimeLeft -= DeltaSeconds;
+	if (UpdateTimeLeft > 0.0f) {
+		return;
+	}
+	UpdateTimeLeft = UpdateInterval;
+
+	ViewLocations.Reset ();
+	for (FConstPlayerControllerIterator Iterator = GetWorld ()->GetPlayerControllerIterator (); Iterator; ++Iterator) {
+		APlayerController* PlayerController = Iterator->Get ();
+		if (PlayerController) {
+			FVector ViewLocation;
+			FRotator ViewRotation;
+			PlayerController->GetPlayerViewPoint (ViewLocation, ViewRotation);
+			ViewLocations.Add (ViewLocation);
+		}
+	}
+
+	for (int32 Idx = Characters.Num () - 1; Idx >= 0; Idx--) {
+		APlatformerCharacter* Character = Characters[Idx].Get ();
+		if (!Character) {
+			Characters.RemoveAtSwap (Idx);
+			continue;
+		}
+
+		const float Score = CalcScore (Character);
+		const EPlatformerSignificance Significance =
+			(Score >= HighScore) ? EPlatformerSignificance::High :
+			(Score >= MediumScore) ? EPlatformerSignificance::Medium :
+			EPlatformerSignificance::Low;
+
+		Character->SetSignificance (Significance);
+	}
+}
+
+float APlatformerSignificanceManager::GetActorTickInterval (EPlatformerSignificance Significance) const {
+	return (Significance == EPlatformerSignificance::Low) ? LowActorTickInterval : 0.0f;
+}
+
+float APlatformerSignificanceManager::GetAnimTickInterval (EPlatformerSignificance Significance) const {
+	switch (Significance) {
+		case EPlatformerSignificance::Medium:
+			return MediumAnimTickInterval;
+
+		case EPlatformerSignificance::Low:
+			return LowAnimTickInterval;
+
+		default:
+			return 0.0f;
+	}
+}
+
+float APlatformerSignificanceManager::CalcScore (const APlatformerCharacter* Character) const {
+	if (Character->IsGameplayRelevant ()) {
+		return 1.0f;
+	}
+
+	const FVector Location = Character->GetActorLocation ();
+	float MinDistSq = MAX_FLT;
+	for (const FVector& ViewLocation : ViewLocations) {
+		MinDistSq = FMath::Min (MinDistSq, FVector::DistSquared (Location, ViewLocation));
+	}
+
+	float Score = 1.0f - FMath::Clamp (FMath::Sqrt (MinDistSq) / MaxDistance, 0.0f, 1.0f);
+
+	// dedicated server doesn't render, distance is all it has
+	const bool bNotRendered = GetNetMode () != NM_DedicatedServer &&
+		GetWorld ()->GetTimeSeconds () - Character->GetLastRenderTime () > NotRenderedTime;
+	if (bNotRendered) {
+		Score *= NotRenderedScoreScale;
+	}
+
+	return Score;
+}
@@ -0,0 +1,64 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "tornadotower.h"
+#include "../Public/PlatformerSlideKernel.h"
+
+void FPlatformerSlideKernel::StepBatch (const FPlatformerSlideBatch& Batch, float DeltaTime) {
+	const VectorRegister Zero = VectorZero ();
+	const VectorRegister One = VectorOne ();
+	const VectorRegister SafeNormalTolerance = VectorSetFloat1 (SMALL_NUMBER);
+	const VectorRegister VecDeltaTime = VectorSetFloat1 (DeltaTime);
+
+	int32 Index = 0;
+	for (; Index + 4 <= Batch.Num; Index += 4) {
+		const VectorRegister VelX = VectorLoad (Batch.VelocityX + Index);
+		const VectorRegister VelY = VectorLoad (Batch.VelocityY + Index);
+		const VectorRegister VelZ = VectorLoad (Batch.VelocityZ + Index);
+
+		// safe normal of velocity, zero for lanes that aren't moving
+		const VectorRegister SpeedSq = VectorMultiplyAdd (VelZ, VelZ, VectorMultiplyAdd (VelY, VelY, VectorMultiply (VelX, VelX)));
+		const VectorRegister IsMoving = VectorCompareGE (SpeedSq, SafeNormalTolerance);
+		const VectorRegister InvSpeed = VectorSelect (IsMoving, VectorReciprocalSqrtAccurate (VectorMax (SpeedSq, SafeNormalTolerance)), Zero);
+		const VectorRegister DirX = VectorMultiply (VelX, InvSpeed);
+		const VectorRegister DirY = VectorMultiply (VelY, InvSpeed);
+		const VectorRegister DirZ = VectorMultiply (VelZ, InvSpeed);
+
+		// accumulate reduction based on floor slope
+		const VectorRegister FloorDotVelocity = VectorMultiplyAdd (VectorLoad (Batch.FloorNormalZ + Index), DirZ,
+			VectorMultiplyAdd (VectorLoad (Batch.FloorNormalY + Index), DirY, VectorMultiply (VectorLoad (Batch.FloorNormalX + Index), DirX)));
+		const VectorRegister SlopeCoef = VectorAdd (One, VectorAbs (FloorDotVelocity));
+		const VectorRegister Rate = VectorSelect (VectorCompareGT (FloorDotVelocity, Zero), VectorLoad (Batch.AccelerationRate + Index), VectorNegate (VectorLoad (Batch.ReductionRate + Index)));
+		const VectorRegister SignedCoef = VectorMultiply (Rate, SlopeCoef);
+		const VectorRegister Reduction = VectorMultiplyAdd (SignedCoef, VecDeltaTime, VectorLoad (Batch.Reduction + Index));
+		VectorStore (Reduction, Batch.Reduction + Index);
+
+		// apply reduction along velocity direction
+		const VectorRegister NewX = VectorMultiplyAdd (Reduction, DirX, VelX);
+		const VectorRegister NewY = VectorMultiplyAdd (Reduction, DirY, VelY);
+		const VectorRegister NewZ = VectorMultiplyAdd (Reduction, DirZ, VelZ);
+		const VectorRegister NewSpeedSq = VectorMultiplyAdd (NewZ, NewZ, VectorMultiplyAdd (NewY, NewY, VectorMultiply (NewX, NewX)));
+
+		// clamp to [MinSpeed, MaxSpeed]
+		const VectorRegister MinSpeed = VectorLoad (Batch.MinSpeed + Index);
+		const VectorRegister MaxSpeed = VectorLoad (Batch.MaxSpeed + Index);
+		const VectorRegister AboveMax = VectorCompareGT (NewSpeedSq, VectorMultiply (MaxSpeed, MaxSpeed));
+		const VectorRegister BelowMin = VectorCompareGT (VectorMultiply (MinSpeed, MinSpeed), NewSpeedSq);
+		const VectorRegister ClampSpeed = VectorSelect (AboveMax, MaxSpeed, MinSpeed);
+		const VectorRegister NeedsClamp = VectorBitwiseOr (AboveMax, BelowMin);
+
+		VectorStore (VectorSelect (NeedsClamp, VectorMultiply (DirX, ClampSpeed), NewX), Batch.VelocityX + Index);
+		VectorStore (VectorSelect (NeedsClamp, VectorMultiply (DirY, ClampSpeed), NewY), Batch.VelocityY + Index);
+		VectorStore (VectorSelect (NeedsClamp, VectorMultiply (DirZ, ClampSpeed), NewZ), Batch.VelocityZ + Index);
+	}
+
+	// remaining sliders go through the scalar path
+	for (; Index < Batch.Num; Index++) {
+		FVector Velocity (Batch.VelocityX[Index], Batch.VelocityY[Index], Batch.VelocityZ[Index]);
+		const FVector FloorNormal (Batch.FloorNormalX[Index], Batch.FloorNormalY[Index], Batch.FloorNormalZ[Index]);
+		Step (Velocity, FloorNormal, Batch.ReductionRate[Index], Batch.AccelerationRate[Index], Batch.MinSpeed[Index], Batch.MaxSpeed[Index], DeltaTime, Batch.Reduction[Index]);
+
+		Batch.VelocityX[Index] = Velocity.X;
+		Batch.VelocityY[Index] = Velocity.Y;
+		Batch.VelocityZ[Index] = Velocity.Z;
+	}
+}
@@ -0,0 +1,50 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "tornadotower.h"
+#include "../Public/PlatformerSpatialHash.h"
+
+FPlatformerSpatialHash::FPlatformerSpatialHash (float InCellSize) {
+	Init (InCellSize);
+}
+
+void FPlatformerSpatialHash::Init (float InCellSize) {
+	check (InCellSize > 0.0f);
+
+	CellSize = InCellSize;
+	InvCellSize = 1.0f / InCellSize;
+	Reset ();
+}
+
+void FPlatformerSpatialHash::Reset () {
+	Cells.Reset ();
+}
+
+void FPlatformerSpatialHash::Add (int32 Element, const FBox& Bounds) {
+	const FIntPoint MinCell = GetCell (Bounds.Min);
+	const FIntPoint MaxCell = GetCell (Bounds.Max);
+	for (int32 CellX = MinCell.X; CellX <= MaxCell.X; CellX++) {
+		for (int32 CellY = MinCell.Y; CellY <= MaxCell.Y; CellY++) {
+			Cells.FindOrAdd (FIntPoint (CellX, CellY)).AddUnique (Element);
+		}
+	}
+}
+
+void FPlatformerSpatialHash::Remove (int32 Element, const FBox& Bounds) {
+	const FIntPoint MinCell = GetCell (Bounds.Min);
+	const FIntPoint MaxCell = GetCell (Bounds.Max);
+	for (int32 CellX = MinCell.X; CellX <= MaxCell.X; CellX++) {
+		for (int32 CellY = MinCell.Y; CellY <= MaxCell.Y; CellY++) {
+			const FIntPoint Cell (CellX, CellY);
+			if (TArray<int32>* Elements = Cells.Find (Cell)) {
+				Elements->RemoveSingleSwap (Element);
+				if (Elements->Num () == 0) {
+					Cells.Remove (Cell);
+				}
+			}
+		}
+	}
+}
+
+const TArray<int32>* FPlatformerSpatialHash::Find (const FVector& Location) const {
+	return Cells.Find (GetCell (Location));
+}
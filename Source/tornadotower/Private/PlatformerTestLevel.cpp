@@ -0,0 +1,103 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "tornadotower.h"
+#include "../Public/PlatformerTestLevel.h"
+#include "../Public/PlatformerCharacter.h"
+#include "../Public/PlatformerPlayerMovementComp.h"
+
+const float FPlatformerTestLevel::ObstacleX = 2000.0f;
+const float FPlatformerTestLevel::ObstacleHeight = 120.0f;
+const float FPlatformerTestLevel::CeilingStartX = -3000.0f;
+const float FPlatformerTestLevel::CeilingEndX = -1000.0f;
+const float FPlatformerTestLevel::CeilingZ = 140.0f;
+
+FPlatformerTestLevel::FPlatformerTestLevel ()
+	: World (NULL) {
+}
+
+FPlatformerTestLevel::~FPlatformerTestLevel () {
+	Destroy ();
+}
+
+bool FPlatformerTestLevel::Create () {
+	check (!World);
+
+	World = UWorld::CreateWorld (EWorldType::Game, false);
+	if (!World) {
+		return false;
+	}
+
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext (EWorldType::Game);
+	WorldContext.SetCurrentWorld (World);
+
+	World->InitializeActorsForPlay (FURL ());
+	World->BeginPlay ();
+
+	// floor
+	SpawnBlock (FVector (0.0f, 0.0f, -50.0f), FVector (10000.0f, 10000.0f, 50.0f));
+
+	// obstacle wall
+	SpawnBlock (FVector (ObstacleX + 50.0f, 0.0f, ObstacleHeight * 0.5f), FVector (50.0f, 2000.0f, ObstacleHeight * 0.5f));
+
+	// low ceiling
+	SpawnBlock (FVector ((CeilingStartX + CeilingEndX) * 0.5f, 0.0f, CeilingZ + 50.0f), FVector ((CeilingEndX - CeilingStartX) * 0.5f, 2000.0f, 50.0f));
+
+	return true;
+}
+
+void FPlatformerTestLevel::Destroy () {
+	if (World) {
+		GEngine->DestroyWorldContext (World);
+		World->DestroyWorld (false);
+		World = NULL;
+	}
+}
+
+APlatformerCharacter* FPlatformerTestLevel::SpawnCharacter (UClass* CharacterClass, float X, float Y) {
+	APlatformerCharacter* DefCharacter = CharacterClass->GetDefaultObject<APlatformerCharacter> ();
+	const float HalfHeight = DefCharacter->GetCapsuleComponent ()->GetUnscaledCapsuleHalfHeight ();
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	APlatformerCharacter* Character = World->SpawnActor<APlatformerCharacter> (CharacterClass, FVector (X, Y, HalfHeight + 1.0f), FRotator::ZeroRotator, SpawnParams);
+	if (Character) {
+		// test pawns have no controller
+		Character->GetCharacterMovement ()->bRunPhysicsWithNoController = true;
+		Character->GetCharacterMovement ()->SetMovementMode (MOVE_Walking);
+	}
+
+	return Character;
+}
+
+AActor* FPlatformerTestLevel::SpawnBlock (const FVector& Center, const FVector& Extent) {
+	AActor* Block = World->SpawnActor<AActor> ();
+
+	UBoxComponent* Box = NewObject<UBoxComponent> (Block);
+	Box->SetBoxExtent (Extent, false);
+	Box->SetWorldLocation (Center);
+	Box->SetCollisionProfileName (UCollisionProfile::BlockAll_ProfileName);
+	Box->SetMobility (EComponentMobility::Static);
+	Block->SetRootComponent (Box);
+	Box->RegisterComponent ();
+
+	return Block;
+}
+
+void FPlatformerTestLevel::SpawnObstacleCourse (float StartX, float EndX, float MinY, float MaxY, float Spacing, int32 Seed) {
+	FRandomStream Random (Seed);
+	const float CenterY = (MinY + MaxY) * 0.5f;
+	const float ExtentY = (MaxY - MinY) * 0.5f;
+
+	for (float X = StartX + Spacing; X < EndX - Spacing; X += Spacing) {
+		if (Random.FRand () < 0.7f) {
+			const float Height = Random.FRandRange (40.0f, 200.0f);
+			SpawnBlock (FVector (X + 50.0f, CenterY, Height * 0.5f), FVector (50.0f, ExtentY, Height * 0.5f));
+		} else {
+			SpawnBlock (FVector (X + 150.0f, CenterY, CeilingZ + 50.0f), FVector (150.0f, ExtentY, 50.0f));
+		}
+	}
+}
+
+void FPlatformerTestLevel::Tick (float DeltaSeconds) {
+	World->Tick (LEVELTICK_All, DeltaSeconds);
+}
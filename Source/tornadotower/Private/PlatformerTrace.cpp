@@ -0,0 +1,123 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "tornadotower.h"
+#include "../Public/PlatformerTrace.h"
+#include "../Public/PlatformerLog.h"
+
+static_assert ((FPlatformerTrace::EventsPerThread & (FPlatformerTrace::EventsPerThread - 1)) == 0, "trace buffer size must be power of two");
+
+namespace PlatformerTrace {
+
+/** events of one thread ; written only by its thread */
+struct FThreadBuffer {
+	uint32 ThreadId;
+
+	/** events written so far, next one goes to WriteCount % EventsPerThread */
+	volatile uint64 WriteCount;
+
+	FPlatformerTraceEvent Events[FPlatformerTrace::EventsPerThread];
+};
+
+/** buffers of all threads that recorded something ; kept after their thread exits, so its last events can be dumped */
+static TArray<FThreadBuffer*> Buffers;
+static FCriticalSection BuffersLock;
+
+static FThreadBuffer* GetThreadBuffer () {
+	static const uint32 TlsSlot = FPlatformTLS::AllocTlsSlot ();
+
+	FThreadBuffer* Buffer = (FThreadBuffer*)FPlatformTLS::GetTlsValue (TlsSlot);
+	if (!Buffer) {
+		Buffer = new FThreadBuffer ();
+		Buffer->ThreadId = FPlatformTLS::GetCurrentThreadId ();
+		Buffer->WriteCount = 0;
+		FPlatformTLS::SetTlsValue (TlsSlot, Buffer);
+
+		FScopeLock Lock (&BuffersLock);
+		Buffers.Add (Buffer);
+	}
+
+	return Buffer;
+}
+
+static void DumpCommand (const TArray<FString>& Args) {
+	FPlatformerTrace::Dump (Args.Num () > 0 ? Args[0] : FPlatformerTrace::GetDefaultDumpFilename ());
+}
+
+static FAutoConsoleCommand DumpConsoleCommand (
+	TEXT ("Platformer.Trace.Dump"),
+	TEXT ("Writes platformer event trace of all threads to file, read it with Tools/PlatformerTraceDecoder. Optional argument: file name"),
+	FConsoleCommandWithArgsDelegate::CreateStatic (&DumpCommand));
+
+static FAutoConsoleVariableRef EnabledConsoleVariable (
+	TEXT ("Platformer.Trace"),
+	FPlatformerTrace::bEnabled,
+	TEXT ("Records platformer movement and input events into per-thread ring buffers"));
+
+}
+
+bool FPlatformerTrace::bEnabled = true;
+
+void FPlatformerTrace::Record (EPlatformerTraceEvent::Type Type, uint32 ObjectId, float Value0, float Value1, uint8 Data) {
+	if (!bEnabled) {
+		return;
+	}
+
+	PlatformerTrace::FThreadBuffer* Buffer = PlatformerTrace::GetThreadBuffer ();
+	FPlatformerTraceEvent& Event = Buffer->Events[Buffer->WriteCount & (EventsPerThread - 1)];
+	Event.Time = FPlatformTime::Seconds () - GStartTime;
+	Event.ObjectId = ObjectId;
+	Event.Type = Type;
+	Event.Data = Data;
+	Event.Reserved = 0;
+	Event.Value0 = Value0;
+	Event.Value1 = Value1;
+
+	// event is complete before dump can see it
+	FPlatformMisc::MemoryBarrier ();
+	Buffer->WriteCount = Buffer->WriteCount + 1;
+}
+
+bool FPlatformerTrace::Dump (const FString& Filename) {
+	TUniquePtr<FArchive> Ar (IFileManager::Get ().CreateFileWriter (*Filename));
+	if (!Ar.IsValid ()) {
+		UE_LOG (LogPlatformer, Error, TEXT ("Failed to open trace file %s"), *Filename);
+		return false;
+	}
+
+	FScopeLock Lock (&PlatformerTrace::BuffersLock);
+
+	FPlatformerTraceFileHeader Header;
+	Header.Magic = PlatformerTraceFormat::FileMagic;
+	Header.Version = PlatformerTraceFormat::FileVersion;
+	Header.EventSize = sizeof (FPlatformerTraceEvent);
+	Header.NumThreads = PlatformerTrace::Buffers.Num ();
+	Header.Reserved = 0;
+	Ar->Serialize (&Header, sizeof (Header));
+
+	uint64 TotalEvents = 0;
+	for (const PlatformerTrace::FThreadBuffer* Buffer : PlatformerTrace::Buffers) {
+		const uint64 WriteCount = Buffer->WriteCount;
+		const uint64 NumEvents = FMath::Min<uint64> (WriteCount, EventsPerThread);
+
+		FPlatformerTraceThreadHeader ThreadHeader;
+		ThreadHeader.ThreadId = Buffer->ThreadId;
+		ThreadHeader.NumEvents = (uint32)NumEvents;
+		ThreadHeader.NumLost = WriteCount - NumEvents;
+		Ar->Serialize (&ThreadHeader, sizeof (ThreadHeader));
+
+		// oldest first ; ring wraps at most once
+		const uint32 First = (uint32)((WriteCount - NumEvents) & (EventsPerThread - 1));
+		const uint32 NumToEnd = FMath::Min<uint32> ((uint32)NumEvents, EventsPerThread - First);
+		Ar->Serialize ((void*)(Buffer->Events + First), NumToEnd * sizeof (FPlatformerTraceEvent));
+		Ar->Serialize ((void*)Buffer->Events, ((uint32)NumEvents - NumToEnd) * sizeof (FPlatformerTraceEvent));
+		TotalEvents += NumEvents;
+	}
+
+	const bool bSuccess = Ar->Close ();
+	UE_LOG (LogPlatformer, Display, TEXT ("Platformer trace: %llu events of %d threads written to %s"), TotalEvents, Header.NumThreads, *Filename);
+	return bSuccess;
+}
+
+FString FPlatformerTrace::GetDefaultDumpFilename () {
+	return FPaths::GameSavedDir () / TEXT ("Traces") / FString::Printf (TEXT ("PlatformerTrace_%s.ptrace"), *FDateTime::Now ().ToString ());
+}
@@ -0,0 +1,88 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "tornadotower.h"
+#include "GameFramework/Info.h"
+#include "PlatformerAudioPool.generated.h"
+
+/** audio component owned by APlatformerAudioPool */
+USTRUCT()
+struct FPlatformerPooledVoice {
+	GENERATED_USTRUCT_BODY()
+
+	UPROPERTY ()
+	UAudioComponent* Component;
+
+	/** incremented every time voice is handed out, invalidating older handles */
+	uint32 Serial;
+
+	/** true while handed out */
+	bool bActive;
+
+	FPlatformerPooledVoice ()
+		: Component (NULL), Serial (0), bActive (false) {
+	}
+};
+
+/** reference to sound played by APlatformerAudioPool ; becomes stale when voice is stopped or stolen */
+struct FPlatformerSoundHandle {
+	int32 Voice;
+	uint32 Serial;
+
+	FPlatformerSoundHandle ()
+		: Voice (INDEX_NONE), Serial (0) {
+	}
+
+	bool IsSet () const {
+		return Voice != INDEX_NONE;
+	}
+
+	void Invalidate () {
+		Voice = INDEX_NONE;
+	}
+};
+
+/**
+* Fixed set of audio components for looped movement sounds (slide, footsteps, wind), shared by all pawns.
+* Components are created once, up to MaxVoices, and reused ; no UObjects are created while playing.
+* When all voices are busy, new sound takes the voice farthest from the listener, unless it is farther itself.
+* Spawned on demand, one per world.
+*/
+UCLASS(config = Game, notplaceable)
+class TORNADOTOWER_API APlatformerAudioPool : public AInfo {
+	GENERATED_UCLASS_BODY()
+public:
+
+	/** returns pool of given world, spawning it if needed ; NULL in worlds without audio */
+	static APlatformerAudioPool* Get (UWorld* World);
+
+	/** creates voices */
+	virtual void PostInitializeComponents () override;
+
+	/** plays Sound attached to given component ; returns unset handle when no voice could be used */
+	FPlatformerSoundHandle Play (USoundBase* Sound, USceneComponent* AttachTo, FName SocketName = NAME_None);
+
+	/** stops sound and returns its voice to pool, clears handle ; does nothing if voice was taken by another sound */
+	void Stop (FPlatformerSoundHandle& Handle);
+
+	/** returns true if handle still owns a playing voice */
+	bool IsPlaying (const FPlatformerSoundHandle& Handle) const;
+
+private:
+	/** maximal number of sounds playing at once, all voices are created up front */
+	UPROPERTY (EditDefaultsOnly, config, Category = Audio)
+		int32 MaxVoices;
+
+	UPROPERTY ()
+		TArray<FPlatformerPooledVoice> Voices;
+
+	/** returns index of voice for new sound at Location, or INDEX_NONE */
+	int32 FindVoice (const FVector& Location) const;
+
+	/** returns location sounds are heard from */
+	FVector GetListenerLocation () const;
+
+	/** stops voice and detaches it from pawn */
+	void ReleaseVoice (FPlatformerPooledVoice& Voice);
+};
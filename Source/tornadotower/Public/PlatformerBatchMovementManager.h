@@ -0,0 +1,98 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "tornadotower.h"
+#include "GameFramework/Info.h"
+#include "PlatformerBatchMovementManager.generated.h"
+
+class UPlatformerPlayerMovementComp;
+
+/** one pawn's walking move of a batch ; filled on game thread, simulated on any thread, applied on game thread */
+struct FPlatformerBatchMove {
+	UPlatformerPlayerMovementComp* Movement;
+	UWorld* World;
+	float DeltaTime;
+
+	/** capsule location and velocity before move, passed to movement updated callbacks */
+	FVector StartLocation;
+	FVector StartVelocity;
+
+	/** pawn capsule, and narrower capsule used to find floor */
+	FCollisionShape Shape;
+	FCollisionShape FloorShape;
+
+	ECollisionChannel Channel;
+	FCollisionQueryParams QueryParams;
+	FCollisionResponseParams ResponseParams;
+
+	/** capsule location after move */
+	FVector EndLocation;
+
+	/** first blocking hit of the move, reported to pawn as impact */
+	FHitResult BlockingHit;
+
+	/** part of move left when it stopped at BlockingHit, for game thread step up */
+	FVector StepUpDelta;
+
+	/** walkable floor below EndLocation */
+	FHitResult FloorHit;
+	float FloorDist;
+
+	/** number of sweeps done */
+	int32 NumTraces;
+
+	/** UsesFixedSlideStep of pawn, it checks net mode which isn't safe on worker threads */
+	uint32 bFixedSlideStep : 1;
+
+	uint32 bBlocked : 1;
+	uint32 bFoundFloor : 1;
+
+	/** BlockingHit is low enough to be a step, move stopped there */
+	uint32 bStepUp : 1;
+};
+
+/**
+* Moves walking AI runners with bUseBatchMovement set as one batch per frame.
+* Inputs are gathered on game thread, velocity integration and collision sweeps of all pawns run
+* in parallel on worker threads, results are applied on game thread in one pass.
+* Pawns that can't be batched this frame (falling, vaulting, jumping, on moving base, using RVO avoidance) tick their movement as usual.
+* Spawned on demand, one per world, not on clients.
+*/
+UCLASS(config = Game, notplaceable)
+class TORNADOTOWER_API APlatformerBatchMovementManager : public AInfo {
+	GENERATED_UCLASS_BODY()
+public:
+
+	/** returns manager of given world, spawning it if needed ; NULL on clients */
+	static APlatformerBatchMovementManager* Get (UWorld* World);
+
+	/** moves batched pawns */
+	virtual void Tick (float DeltaSeconds) override;
+
+	/** starts batching movement ; its tick runs after manager's, skipping movement done by the batch */
+	void RegisterMovement (UPlatformerPlayerMovementComp* Movement);
+
+	/** stops batching movement */
+	void UnregisterMovement (UPlatformerPlayerMovementComp* Movement);
+
+	/** returns number of pawns moved by last batch */
+	int32 GetNumBatched () const {
+		return Moves.Num ();
+	}
+
+private:
+	/** false moves every registered pawn by its own tick */
+	UPROPERTY (config)
+		uint32 bEnableBatchMovement : 1;
+
+	/** batches smaller than this run on game thread, as task overhead outweighs the gain */
+	UPROPERTY (config)
+		int32 MinParallelMoves;
+
+	/** registered movement components */
+	TArray<TWeakObjectPtr<UPlatformerPlayerMovementComp>> Movements;
+
+	/** moves of current frame */
+	TArray<FPlatformerBatchMove> Moves;
+};
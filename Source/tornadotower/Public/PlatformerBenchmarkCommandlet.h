@@ -0,0 +1,36 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "tornadotower.h"
+#include "Commandlets/Commandlet.h"
+#include "PlatformerBenchmarkCommandlet.generated.h"
+
+class APlatformerCharacter;
+class UPlatformerPlayerMovementComp;
+
+/**
+* Times platformer movement hot paths in isolation on FPlatformerTestLevel.
+*
+* Usage:
+*   -run=PlatformerBenchmark [-Iterations=N] [-Output=File.json] [-Baseline=File.json] [-Tolerance=0.1] [-SlideLODTolerance=0.05]
+*
+* Results (ns per call, game thread allocations per call) are written as JSON to Output.
+* When Baseline is given, every case slower than baseline by more than Tolerance, or allocating more,
+* is reported as a regression and the commandlet returns non-zero.
+* Also slides a pawn at 60 Hz and in reduced movement LOD over the same time, and returns non-zero
+* if accumulated slide reduction or speed differ by more than SlideLODTolerance.
+*/
+UCLASS()
+class UPlatformerBenchmarkCommandlet : public UCommandlet {
+	GENERATED_UCLASS_BODY()
+
+	virtual int32 Main (const FString& Params) override;
+
+private:
+	/**
+	* slides pawn from Location at 60 Hz and in reduced movement LOD over the same time
+	* returns false if accumulated slide reduction or speed of reduced LOD differs from full rate by more than Tolerance
+	*/
+	static bool CheckSlideLOD (APlatformerCharacter* Character, UPlatformerPlayerMovementComp* MoveComp, const FVector& Location, float Tolerance);
+};
@@ -6,13 +6,39 @@
 #include "Components/ActorComponent.h"
 #include "GameFramework/Pawn.h"
 #include "GameFramework/Character.h"
+#include "PlatformerInputRecording.h"
+#include "PlatformerAudioPool.h"
+#include "PlatformerInputBuffer.h"
 #include "PlatformerCharacter.generated.h"
 
+class APlatformerClimbMarker;
+class APlatformerObstacleIndex;
+class APlatformerRoundManager;
+class APlatformerSignificanceManager;
+enum class EPlatformerObstacleClass : uint8;
+enum class EPlatformerSignificance : uint8;
+
+/** reasons for APlatformerCharacter to tick ; character ticks only while at least one is active */
+namespace EPlatformerTickReason {
+	enum Type {
+		/** mesh is blending out of AnimPositionAdjustment */
+		AnimPositionAdjustment = 1 << 0,
+		/** following moving ClimbToMarker */
+		ClimbToMarker = 1 << 1,
+		/** blueprint implements Tick event */
+		Blueprint = 1 << 2,
+		/** feeding recorded input, see -PlatformerReplay */
+		InputReplay = 1 << 3,
+	};
+}
+
 // ClassGroup = (Custom), meta = (BlueprintSpawnableComponent)
 UCLASS()
 class TORNADOTOWER_API APlatformerCharacter : public ACharacter {
 	GENERATED_UCLASS_BODY()
 
+	friend class UPlatformerBenchmarkCommandlet;
+
 	/** Camera boom positioning the camera behind the character */
 	UPROPERTY (VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
 	class USpringArmComponent* CameraBoom;
@@ -32,20 +58,64 @@ public:
 	/** player pawn initialization */
 	virtual void PostInitializeComponents ();
 
-	/** perform position adjustments */
+	/** cache level data used by movement, audio pool and round flow, register for significance management */
+	virtual void BeginPlay ();
+
+	/** unregister from significance management, release pooled sounds, save input recording */
+	virtual void EndPlay (const EEndPlayReason::Type EndPlayReason);
+
+	/**
+	* starts input recording or replay for first local player pawn, based on command line:
+	*   -PlatformerRecord=File          records input at fixed time step until pawn is gone
+	*   -PlatformerReplay=File          replays recorded input and exits, use with -nullrhi
+	*   -PlatformerReplayReport=File    writes replay frame times and final pawn state as JSON
+	*/
+	virtual void PossessedBy (AController* NewController);
+
+	/** perform position adjustments ; disables itself when there is nothing to adjust */
 	virtual void Tick (float DeltaSeconds);
 
+	/** enables tick for given EPlatformerTickReason */
+	void AddTickReason (uint32 Reason);
+
+	/** clears given EPlatformerTickReason, disables tick when no reason is left */
+	void RemoveTickReason (uint32 Reason);
+
+	/** returns active EPlatformerTickReason flags */
+	uint32 GetTickReasons () const;
+
+	/** returns readable list of active tick reasons */
+	FString DescribeTickReasons () const;
+
 	/** setup input bindings */
 	virtual void SetupPlayerInputComponent (class UInputComponent* InputComponent);
 
 	/** used to make pawn jump ; overridden to handle additional jump input functionality */
 	virtual void CheckJumpInput (float DeltaTime);
 
+	/** also allows jumping during movement's coyote time */
+	virtual bool CanJumpInternal_Implementation () const override;
+
 	/** notify from movement about hitting an obstacle while running */
 	virtual void MoveBlockedBy (const FHitResult& Impact);
 
+	/** notify from movement about obstacle right ahead of running pawn, found by look-ahead sweep */
+	void OnObstacleAhead (const FHitResult& Hit);
+
+	/**
+	* owning client ran into an obstacle at its move ClientTimeStamp, or was about to if bLookAhead is set
+	* server rewinds movement history to that time, sweeps for the obstacle itself and vaults only if it finds one
+	*/
+	UFUNCTION (Server, Reliable, WithValidation)
+	void ServerObstacleHit (float ClientTimeStamp, bool bLookAhead);
+	bool ServerObstacleHit_Validate (float ClientTimeStamp, bool bLookAhead);
+	void ServerObstacleHit_Implementation (float ClientTimeStamp, bool bLookAhead);
+
+	/** notify from movement that server simulated owning client's move ClientTimeStamp ; confirms obstacle hit waiting for it */
+	void OnClientMoveProcessed (float ClientTimeStamp);
+
 	/** play end of round if game has finished with character in mid air */
-	//virtual void Landed (const FHitResult& Hit);
+	virtual void Landed (const FHitResult& Hit);
 
 	/** try playing end of round animation */
 	void OnRoundFinished ();
@@ -60,6 +130,20 @@ public:
 	/** gets bPressedSlide value */
 	bool WantsToSlide ();
 
+	/** sets bPressedSlide value ; used by movement to apply slide input from saved moves */
+	void SetWantsToSlide (bool bWants);
+
+	/** timestamped presses and movement basis, read by movement at start of its tick */
+	FPlatformerInputBuffer& GetInputBuffer () {
+		return InputBuffer;
+	}
+
+	/** jump input ; overridden for input recording and buffering */
+	virtual void Jump ();
+
+	/** stop jump input ; overridden for input recording */
+	virtual void StopJumping ();
+
 	/** event called when player presses jump button */
 	void OnStartJump ();
 
@@ -78,8 +162,49 @@ public:
 	/** handle effects when slide is finished */
 	void PlaySlideFinished ();
 
+	/**
+	* determine obstacle height type and play animation ; called by movement during vault
+	* returns animation length, 0 if there is nothing to climb
+	*/
+	float ClimbOverObstacle ();
+
+	/**
+	* place pawn on top of grabbed ledge and play climb animation ; called by movement during ledge grab
+	* returns animation length, 0 if pawn can't climb
+	*/
+	float ClimbToLedge (const APlatformerClimbMarker* MoveToMarker);
+
+	/** returns true if pawn has what ClimbToLedge needs to climb to given marker */
+	bool CanClimbToLedge (const APlatformerClimbMarker* MoveToMarker) const;
+
+	/** restore pawn's movement state ; called by movement when vault or ledge climb ends */
+	void ResumeMovement ();
+
+	/** returns height type of obstacle for climbing, Height is measured from pawn's feet */
+	EPlatformerObstacleClass ClassifyObstacleHeight (float Height) const;
+
+	/** returns length of climb over animation for given obstacle class, 0 if there is none */
+	float GetClimbOverDuration (EPlatformerObstacleClass Class) const;
+
+	/** applies tick rates and bone update mode for given significance */
+	void SetSignificance (EPlatformerSignificance NewSignificance);
+
+	/** returns current significance */
+	EPlatformerSignificance GetSignificance () const;
+
+	/** returns true when character must be fully simulated regardless of distance and visibility */
+	bool IsGameplayRelevant () const;
+
+	/** restores high significance immediately, and keeps it for SignificanceHoldTime */
+	void MarkGameplayRelevant ();
+
 	/** gets CameraHeightChangeThreshold value */
-	float GetCameraHeightChangeThreshold ();
+	float GetCameraHeightChangeThreshold () const;
+
+	/** returns camera boom ; its arm and probe settings are used by APlatformerPlayerCameraManager */
+	USpringArmComponent* GetCameraBoom () const {
+		return CameraBoom;
+	}
 
 
 	/**
@@ -146,6 +271,27 @@ private:
 	UPROPERTY (EditDefaultsOnly, Category = Config)
 		float CameraHeightChangeThreshold;
 
+	/** time character stays gameplay relevant after slide, obstacle hit or climb */
+	UPROPERTY (EditDefaultsOnly, Category = Significance)
+		float SignificanceHoldTime;
+
+	/** manager scoring this character */
+	TWeakObjectPtr<APlatformerSignificanceManager> SignificanceManager;
+
+	/** current significance */
+	EPlatformerSignificance Significance;
+
+	/** world time of last gameplay relevant event */
+	float LastGameplayEventTime;
+
+	/** allowed distance between rewound capsule and obstacle client reported hitting */
+	UPROPERTY (EditDefaultsOnly, Category = Network)
+		float MaxObstacleHitError;
+
+	/** time of travel along rewound velocity server's look-ahead sweep covers when confirming client's look-ahead vault */
+	UPROPERTY (EditDefaultsOnly, Category = Network)
+		float MaxLookAheadHitTime;
+
 	/** animation for winning game */
 	UPROPERTY (EditDefaultsOnly, Category = Animation)
 		UAnimMontage* WonMontage;
@@ -201,6 +347,9 @@ private:
 	/** mesh translation used for position adjustments */
 	FVector AnimPositionAdjustment;
 
+	/** active EPlatformerTickReason flags */
+	uint32 TickReasons;
+
 	/** root motion translation from previous tick */
 	FVector PrevRootMotionPosition;
 
@@ -208,9 +357,14 @@ private:
 	UPROPERTY (EditDefaultsOnly, Category = Sound)
 		USoundCue* SlideSound;
 
-	/** audio component playing looped slide sound */
-	UPROPERTY ()
-		UAudioComponent* SlideAC;
+	/** pooled voice playing looped slide sound */
+	FPlatformerSoundHandle SlideSoundHandle;
+
+	/** shared voices for looped movement sounds */
+	TWeakObjectPtr<APlatformerAudioPool> AudioPool;
+
+	/** round flow of current world, server only */
+	TWeakObjectPtr<APlatformerRoundManager> RoundManager;
 
 	/** true when player is holding slide button */
 	uint32 bPressedSlide : 1;
@@ -218,6 +372,9 @@ private:
 	/** true when player is holding jump button */
 	uint32 bPressedJump : 1;
 
+	/** recent presses and cached yaw basis of input */
+	FPlatformerInputBuffer InputBuffer;
+
 	/** ClimbMarker (or to be exact its mesh component - the movable part) we are climbing to */
 	UPROPERTY ()
 		UStaticMeshComponent* ClimbToMarker;
@@ -225,17 +382,41 @@ private:
 	/** location of ClimbMarker we are climbing to */
 	FVector ClimbToMarkerLocation;
 
-	/** Handle for efficient management of ClimbOverObstacle timer */
-	FTimerHandle TimerHandle_ClimbOverObstacle;
+	/** baked obstacle tops of current level, if level was baked */
+	TWeakObjectPtr<APlatformerObstacleIndex> ObstacleIndex;
 
-	/** Handle for efficient management of ResumeMovement timer */
-	FTimerHandle TimerHandle_ResumeMovement;
+	/** component pawn ran into, used to decide between baked obstacle data and trace */
+	TWeakObjectPtr<UPrimitiveComponent> ObstacleHitComponent;
 
-	/** determine obstacle height type and play animation */
-	void ClimbOverObstacle ();
+	/** input recorded from this pawn, if recording */
+	TUniquePtr<FPlatformerInputRecorder> InputRecorder;
 
-	/** restore pawn's movement state */
-	void ResumeMovement ();
+	/** input replayed into this pawn, if replaying */
+	TUniquePtr<FPlatformerInputReplay> InputReplay;
+
+	/** client time stamp of obstacle hit received before its move */
+	float PendingObstacleHitTimeStamp;
+
+	/** world time pending obstacle hit was received */
+	float PendingObstacleHitReceiveTime;
+
+	/** true while an obstacle hit waits for its move to be simulated */
+	uint32 bHasPendingObstacleHit : 1;
+
+	/** bLookAhead of pending obstacle hit */
+	uint32 bPendingObstacleHitLookAhead : 1;
+
+	/** checks obstacle hit of owning client against movement history and vaults from current location if server finds the obstacle too */
+	void ConfirmObstacleHit (float ClientTimeStamp, bool bLookAhead);
+
+	/** play hit reaction and start vault in movement ; look-ahead vaults skip hit reaction and keep speed */
+	void StartObstacleHit (UPrimitiveComponent* HitComponent, float Speed, bool bLookAhead);
+
+	/** sets mesh translation used for position adjustments, ticking until it reaches zero */
+	void SetAnimPositionAdjustment (const FVector& Adjustment);
+
+	/** sets climb marker to follow, ticking while it's set */
+	void SetClimbToMarker (UStaticMeshComponent* Marker);
 
 	/** play end of round animation */
 	void PlayRoundFinished ();
@@ -0,0 +1,120 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "tornadotower.h"
+#include "GameFramework/Actor.h"
+#include "GameFramework/Info.h"
+#include "PlatformerSpatialHash.h"
+#include "PlatformerClimbMarker.generated.h"
+
+class APlatformerClimbMarkerRegistry;
+
+/**
+* Ledge pawns can grab while in mid air.
+* Top front edge (minimal X, maximal Z) of mesh bounds is the grab point.
+* Registers itself in APlatformerClimbMarkerRegistry for as long as it's in play.
+*/
+UCLASS()
+class TORNADOTOWER_API APlatformerClimbMarker : public AActor {
+	GENERATED_UCLASS_BODY()
+
+	friend class APlatformerClimbMarkerRegistry;
+public:
+
+	/** registers marker for ledge queries */
+	virtual void BeginPlay () override;
+
+	/** unregisters marker */
+	virtual void EndPlay (const EEndPlayReason::Type EndPlayReason) override;
+
+	/** returns marker mesh */
+	UStaticMeshComponent* GetMesh () const {
+		return Mesh;
+	}
+
+	/** returns world bounds of marker mesh */
+	FBox GetLedgeBounds () const;
+
+private:
+	/** marker mesh, the movable part pawns climb to */
+	UPROPERTY (VisibleDefaultsOnly, Category = Mesh, meta = (AllowPrivateAccess = "true"))
+		UStaticMeshComponent* Mesh;
+
+	/** registry marker was added to */
+	TWeakObjectPtr<APlatformerClimbMarkerRegistry> Registry;
+
+	/** index of marker's entry in registry */
+	int32 RegistryEntry;
+};
+
+/** climb marker registered in APlatformerClimbMarkerRegistry */
+struct FPlatformerClimbMarkerEntry {
+	/** registered marker ; unset for free slots */
+	TWeakObjectPtr<APlatformerClimbMarker> Marker;
+
+	/** bounds marker was added to grid with */
+	FBox Bounds;
+
+	/** true if marker mesh can move, its cells are refreshed every tick */
+	bool bMovable;
+
+	FPlatformerClimbMarkerEntry ()
+		: Bounds (ForceInit), bMovable (false) {
+	}
+};
+
+/**
+* Uniform grid of climb markers in a world.
+* Ledge query visits only the few cells around grab point, so its cost doesn't depend on number of markers in level.
+* Movable markers are moved between cells in Tick ; registry ticks only while there are some.
+* Spawned on demand, one per world.
+*/
+UCLASS(config = Game, notplaceable)
+class TORNADOTOWER_API APlatformerClimbMarkerRegistry : public AInfo {
+	GENERATED_UCLASS_BODY()
+public:
+
+	/** returns registry of given world, spawning it if needed */
+	static APlatformerClimbMarkerRegistry* Get (UWorld* World);
+
+	/** sets up grid */
+	virtual void PostInitializeComponents () override;
+
+	/** refreshes grid cells of movable markers */
+	virtual void Tick (float DeltaSeconds) override;
+
+	/** adds marker to grid */
+	void RegisterMarker (APlatformerClimbMarker* Marker);
+
+	/** removes marker from grid */
+	void UnregisterMarker (APlatformerClimbMarker* Marker);
+
+	/**
+	* finds marker with its grab point inside GrabBounds, closest to GrabBounds.Min along X
+	* returns NULL if there is no ledge in reach
+	*/
+	APlatformerClimbMarker* FindLedge (const FBox& GrabBounds) const;
+
+	/** returns number of registered markers */
+	int32 GetNumMarkers () const {
+		return Entries.Num () - FreeEntries.Num ();
+	}
+
+private:
+	/** size of grid cell, should be larger than grab reach of pawns */
+	UPROPERTY (EditDefaultsOnly, config, Category = Grid)
+		float CellSize;
+
+	/** registered markers, grid stores indices into this array */
+	TArray<FPlatformerClimbMarkerEntry> Entries;
+
+	/** unused indices in Entries */
+	TArray<int32> FreeEntries;
+
+	/** number of registered movable markers */
+	int32 NumMovable;
+
+	/** lookup grid */
+	FPlatformerSpatialHash Grid;
+};
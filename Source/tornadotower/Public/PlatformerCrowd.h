@@ -0,0 +1,234 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "tornadotower.h"
+#include "GameFramework/Actor.h"
+#include "PlatformerObstacleIndex.h"
+#include "PlatformerCrowd.generated.h"
+
+class APlatformerCharacter;
+
+/** what a crowd runner is doing */
+namespace EPlatformerCrowdState {
+	enum Type : uint8 {
+		Run,
+		Slide,
+		/** climbing over obstacle, moved from VaultStart to VaultEnd */
+		Vault,
+		Fall
+	};
+}
+
+namespace PlatformerCrowd {
+	/** instance X scale is 1 + FrameScaleEncoding * Frame / NumAnimationFrames, small enough not to be seen */
+	static const float FrameScaleEncoding = 0.01f;
+}
+
+/** frames of one animation in crowd's vertex animation texture */
+USTRUCT()
+struct FPlatformerCrowdClip {
+	GENERATED_USTRUCT_BODY()
+
+	UPROPERTY (EditAnywhere, Category = Animation)
+	int32 FirstFrame;
+
+	UPROPERTY (EditAnywhere, Category = Animation)
+	int32 NumFrames;
+
+	/** looping clips wrap around, others hold their last frame */
+	UPROPERTY (EditAnywhere, Category = Animation)
+	bool bLoop;
+
+	FPlatformerCrowdClip ()
+		: FirstFrame (0), NumFrames (1), bLoop (true) {
+	}
+};
+
+/**
+* Background crowd of runners without actors. Each runner is an entry in contiguous arrays, simulated with
+* movement rules of RunnerClass: run speed and acceleration, slide through FPlatformerSlideKernel, obstacle classes
+* and climb durations of its climb over animations. All runners are drawn by one instanced mesh.
+* Runners run along X from crowd's location over CourseLength and start over at its end. They vault obstacles
+* baked in APlatformerObstacleIndex and don't collide with anything else.
+*
+* RunnerMesh is expected to use a vertex animation material: clips are stacked in one texture of NumAnimationFrames rows
+* and the frame of each instance is passed in its X scale, see PlatformerCrowd::FrameScaleEncoding.
+* Runners are only drawn, so crowd doesn't tick on dedicated servers.
+*/
+UCLASS()
+class TORNADOTOWER_API APlatformerCrowd : public AActor {
+	GENERATED_UCLASS_BODY()
+public:
+
+	/** reads movement rules from RunnerClass and spawns runners */
+	virtual void BeginPlay () override;
+
+	/** moves runners and updates their instances */
+	virtual void Tick (float DeltaSeconds) override;
+
+	/** places NumRunners runners at random spots of the course */
+	void ResetRunners ();
+
+	/** sets NumRunners, placing runners anew if crowd already plays */
+	void SetNumRunners (int32 InNumRunners);
+
+	int32 GetNumRunners () const {
+		return PosX.Num ();
+	}
+
+private:
+	/** one instance per runner ; not hierarchical, its cluster tree would be rebuilt every frame as every runner moves */
+	UPROPERTY (VisibleAnywhere, Category = Crowd)
+		UInstancedStaticMeshComponent* Instances;
+
+	/** character whose movement and climb settings runners use */
+	UPROPERTY (EditAnywhere, Category = Crowd)
+		TSubclassOf<APlatformerCharacter> RunnerClass;
+
+	UPROPERTY (EditAnywhere, Category = Crowd)
+		int32 NumRunners;
+
+	/** distance along X runners cover before starting over */
+	UPROPERTY (EditAnywhere, Category = Crowd)
+		float CourseLength;
+
+	/** width of course along Y, centered on crowd's location */
+	UPROPERTY (EditAnywhere, Category = Crowd)
+		float CourseWidth;
+
+	/** chance per second that running runner starts sliding */
+	UPROPERTY (EditAnywhere, Category = Crowd)
+		float SlideChance;
+
+	/** climb duration used if RunnerClass has no animation for obstacle class */
+	UPROPERTY (EditAnywhere, Category = Crowd)
+		float DefaultClimbDuration;
+
+	/** mesh with vertex animation material */
+	UPROPERTY (EditAnywhere, Category = Animation)
+		UStaticMesh* RunnerMesh;
+
+	/** total frames in vertex animation texture */
+	UPROPERTY (EditAnywhere, Category = Animation)
+		int32 NumAnimationFrames;
+
+	/** frames per second of all clips */
+	UPROPERTY (EditAnywhere, Category = Animation)
+		float AnimationFrameRate;
+
+	UPROPERTY (EditAnywhere, Category = Animation)
+		FPlatformerCrowdClip RunClip;
+
+	UPROPERTY (EditAnywhere, Category = Animation)
+		FPlatformerCrowdClip SlideClip;
+
+	UPROPERTY (EditAnywhere, Category = Animation)
+		FPlatformerCrowdClip FallClip;
+
+	/** climb over clip per EPlatformerObstacleClass */
+	UPROPERTY (EditAnywhere, Category = Animation)
+		FPlatformerCrowdClip ClimbOverSmallClip;
+
+	UPROPERTY (EditAnywhere, Category = Animation)
+		FPlatformerCrowdClip ClimbOverMidClip;
+
+	UPROPERTY (EditAnywhere, Category = Animation)
+		FPlatformerCrowdClip ClimbOverBigClip;
+
+	/** movement rules read from RunnerClass in BeginPlay */
+	float RunSpeed;
+	float RunAcceleration;
+	float SlideReductionRate;
+	float MinSlideSpeed;
+	float MaxSlideSpeed;
+	float ObstacleHitSpeedScale;
+	float LookAheadVaultSpeedScale;
+	float LookAheadMinSpeed;
+	float GravityZ;
+	float StepHeight;
+	float Radius;
+	float HalfHeight;
+	float ClimbDurations[3];
+
+	/** default object of RunnerClass, classifies obstacles */
+	const APlatformerCharacter* RunnerDefaults;
+
+	/** world Z runners run at outside obstacles */
+	float GroundZ;
+
+	/** baked obstacles of current level */
+	TWeakObjectPtr<APlatformerObstacleIndex> ObstacleIndex;
+
+	FRandomStream Random;
+
+	/** runner feet location */
+	TArray<float> PosX;
+	TArray<float> PosY;
+	TArray<float> PosZ;
+
+	/** speed along X */
+	TArray<float> Speed;
+
+	/** vertical speed while falling */
+	TArray<float> VelZ;
+
+	/** Z runner walks at and X where that floor ends */
+	TArray<float> FloorZ;
+	TArray<float> FloorEndX;
+
+	/** accumulated slide velocity reduction, as CurrentSlideVelocityReduction of movement */
+	TArray<float> SlideReduction;
+
+	/** time spent in current state, drives animation */
+	TArray<float> StateTime;
+
+	/** vault path and length */
+	TArray<float> VaultStartX;
+	TArray<float> VaultStartZ;
+	TArray<float> VaultEndX;
+	TArray<float> VaultEndZ;
+	TArray<float> VaultDuration;
+
+	/** EPlatformerCrowdState */
+	TArray<uint8> State;
+
+	/** EPlatformerObstacleClass of current vault */
+	TArray<uint8> VaultClass;
+
+	/** sliders of current frame, packed for FPlatformerSlideKernel::StepBatch */
+	TArray<int32> SliderIndices;
+	TArray<float> SlideVelocityX;
+	TArray<float> SlideVelocityY;
+	TArray<float> SlideVelocityZ;
+	TArray<float> SlideReductionScratch;
+
+	/** per lane constants of slide batch, sized to NumRunners */
+	TArray<float> SlideFloorNormalX;
+	TArray<float> SlideFloorNormalY;
+	TArray<float> SlideFloorNormalZ;
+	TArray<float> SlideReductionRates;
+	TArray<float> SlideMinSpeeds;
+	TArray<float> SlideMaxSpeeds;
+
+	/** copies movement rules of RunnerClass */
+	void ReadRunnerRules ();
+
+	/** advances running, vaulting and falling runners, starting slides and vaults */
+	void UpdateRunners (float DeltaTime);
+
+	/** steps all sliders as one batch */
+	void UpdateSliders (float DeltaTime);
+
+	/** moves instances to runner locations with current animation frame */
+	void UpdateInstances ();
+
+	/** looks for obstacle in front of runner and starts climbing it ; returns true if vault started */
+	bool TryStartVault (int32 Runner, float DeltaTime);
+
+	/** switches runner to new state */
+	void SetState (int32 Runner, EPlatformerCrowdState::Type NewState);
+
+	/** returns clip of runner's current state */
+	const FPlatformerCrowdClip& GetClip (int32 Runner) const;
+};
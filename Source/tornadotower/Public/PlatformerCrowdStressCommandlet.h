@@ -0,0 +1,29 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "tornadotower.h"
+#include "Commandlets/Commandlet.h"
+#include "PlatformerCrowdStressCommandlet.generated.h"
+
+/**
+* Runs crowds of platformer characters over a generated obstacle course on FPlatformerTestLevel,
+* sliding, jumping and climbing over obstacles, and reports game thread frame time percentiles.
+*
+* Usage:
+*   -run=PlatformerCrowdStress [-Runners=10,100,1000] [-Frames=N] [-Character=Class] [-Significance] [-Batch] [-Crowd] [-Output=File.json]
+*
+* Every crowd size in Runners (10 to 1000) is run in a fresh level. Frame time is split into
+* movement, animation and explicit collision queries (see FPlatformerPerfCounters).
+* Significance management and movement LOD are off unless -Significance is given,
+* as nothing is rendered and every runner would be throttled.
+* -Batch moves runners through APlatformerBatchMovementManager, movement time then includes the batch.
+* -Crowd runs the same sizes as one APlatformerCrowd instead of characters and reports its tick time,
+* to compare cost per runner with full pawns.
+*/
+UCLASS()
+class UPlatformerCrowdStressCommandlet : public UCommandlet {
+	GENERATED_UCLASS_BODY()
+
+	virtual int32 Main (const FString& Params) override;
+};
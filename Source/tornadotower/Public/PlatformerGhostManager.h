@@ -0,0 +1,115 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "tornadotower.h"
+#include "GameFramework/Info.h"
+#include "PlatformerGhostTrack.h"
+#include "PlatformerGhostManager.generated.h"
+
+class APlatformerCharacter;
+
+/**
+* Time trial ghosts: records player's run and plays back fastest earlier runs of current map.
+* Ghosts aren't actors ; every pose has one instanced mesh component holding an instance per ghost,
+* instances of poses a ghost isn't in are scaled to zero. Tracks are read straight from mapped files,
+* so playback doesn't allocate.
+* Spawned on demand, one per world, not on dedicated servers.
+*/
+UCLASS(config = Game, notplaceable)
+class TORNADOTOWER_API APlatformerGhostManager : public AInfo {
+	GENERATED_UCLASS_BODY()
+public:
+
+	/** returns ghost manager of given world, spawning it if needed ; NULL on dedicated servers */
+	static APlatformerGhostManager* Get (UWorld* World);
+
+	/** creates instanced meshes and opens ghosts of current map */
+	virtual void PostInitializeComponents () override;
+
+	/** records and plays back ghosts */
+	virtual void Tick (float DeltaSeconds) override;
+
+	/** starts recording Character and restarts playback of ghosts, picking up runs saved since last start */
+	void StartRun (APlatformerCharacter* Character);
+
+	/** stops recording, saving run if it was finished ; ghosts play to their end */
+	void FinishRun (bool bSave);
+
+	/** closes ghosts and opens fastest MaxGhosts runs of current map */
+	void LoadGhosts ();
+
+	/** returns directory ghosts of current map are stored in */
+	FString GetGhostDirectory () const;
+
+	/** returns number of loaded ghosts */
+	int32 GetNumGhosts () const {
+		return Tracks.Num ();
+	}
+
+private:
+	/** mesh drawn for each EPlatformerGhostPose */
+	UPROPERTY (config)
+		FStringAssetReference RunMesh;
+
+	UPROPERTY (config)
+		FStringAssetReference SlideMesh;
+
+	UPROPERTY (config)
+		FStringAssetReference VaultMesh;
+
+	UPROPERTY (config)
+		FStringAssetReference FallMesh;
+
+	/** maximal number of ghosts played at once */
+	UPROPERTY (config)
+		int32 MaxGhosts;
+
+	/** samples recorded per second */
+	UPROPERTY (config)
+		float SampleRate;
+
+	/** samples between absolute keyframes */
+	UPROPERTY (config)
+		int32 KeyframeInterval;
+
+	/** instances of all ghosts, one component per EPlatformerGhostPose */
+	UPROPERTY ()
+		TArray<UInstancedStaticMeshComponent*> PoseInstances;
+
+	/** opened ghost files */
+	TArray<TUniquePtr<FPlatformerGhostTrack>> Tracks;
+
+	/** playback position of each track */
+	TArray<FPlatformerGhostCursor> Cursors;
+
+	/** pose each ghost is currently shown with */
+	TArray<EPlatformerGhostPose::Type> GhostPoses;
+
+	/** run being recorded */
+	TUniquePtr<FPlatformerGhostWriter> Recording;
+
+	/** pawn being recorded */
+	TWeakObjectPtr<APlatformerCharacter> RecordedCharacter;
+
+	/** time since run start */
+	float RunTime;
+
+	/** run time of next recorded sample */
+	float NextSampleTime;
+
+	/** true while ghosts are moving */
+	uint32 bPlaying : 1;
+
+	/** true if a new run was saved, ghosts are reopened when next run starts */
+	uint32 bReloadGhosts : 1;
+
+	/** false if a pose mesh couldn't be loaded ; runs are still recorded, but ghosts aren't played */
+	uint32 bPoseMeshesLoaded : 1;
+
+	/** moves ghost instances to RunTime */
+	void UpdateGhosts ();
+
+	/** enables tick while recording or playing */
+	void UpdateTickEnabled ();
+};
@@ -0,0 +1,218 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "tornadotower.h"
+
+class APlatformerCharacter;
+
+/** pose of ghost, picks instanced mesh it is drawn with */
+namespace EPlatformerGhostPose {
+	enum Type : uint8 {
+		Run,
+		Slide,
+		Vault,
+		Fall,
+
+		Num
+	};
+}
+
+/**
+* Ghost file layout, read in place from mapped memory:
+*   FPlatformerGhostHeader
+*   FPlatformerGhostKeyframe[(NumSamples + KeyframeInterval - 1) / KeyframeInterval]
+*   FPlatformerGhostSample[NumSamples]
+* Positions are quantized to 1 / PositionScale cm. Every KeyframeInterval-th sample starts from an absolute keyframe,
+* other samples store delta from previous sample, so a ghost costs 8 bytes per sample.
+*/
+struct FPlatformerGhostHeader {
+	uint32 Magic;
+	uint16 Version;
+	uint16 KeyframeInterval;
+	float SampleInterval;
+	uint32 NumSamples;
+	uint32 Reserved;
+};
+
+struct FPlatformerGhostKeyframe {
+	int32 X;
+	int32 Y;
+	int32 Z;
+};
+
+struct FPlatformerGhostSample {
+	int16 DeltaX;
+	int16 DeltaY;
+	int16 DeltaZ;
+	/** yaw quantized to 256 steps */
+	uint8 Yaw;
+	/** EPlatformerGhostPose */
+	uint8 Pose;
+};
+
+static_assert (sizeof (FPlatformerGhostHeader) == 20, "ghost header is read from file in place");
+static_assert (sizeof (FPlatformerGhostKeyframe) == 12, "ghost keyframe is read from file in place");
+static_assert (sizeof (FPlatformerGhostSample) == 8, "ghost sample is read from file in place");
+
+namespace PlatformerGhost {
+	/** 'PGHO' */
+	static const uint32 FileMagic = 0x5047484F;
+	static const uint16 FileVersion = 1;
+
+	/** quantization steps per cm */
+	static const float PositionScale = 2.0f;
+
+	/** yaw just below 360 rounds to 256, which wraps to 0 */
+	FORCEINLINE uint8 QuantizeYaw (float Yaw) {
+		return (uint8)(FMath::RoundToInt (FRotator::ClampAxis (Yaw) * (256.0f / 360.0f)) & 0xFF);
+	}
+
+	FORCEINLINE float DequantizeYaw (uint8 Yaw) {
+		return Yaw * (360.0f / 256.0f);
+	}
+}
+
+/** collects ghost samples of a pawn at fixed rate and writes them to file */
+class TORNADOTOWER_API FPlatformerGhostWriter {
+public:
+	FPlatformerGhostWriter (float InSampleInterval, uint16 InKeyframeInterval);
+
+	/** adds sample ; samples are SampleInterval apart */
+	void AddSample (const FVector& Location, float Yaw, EPlatformerGhostPose::Type Pose);
+
+	/** adds sample from pawn's current state */
+	void AddSample (const APlatformerCharacter* Character);
+
+	/** returns pose matching pawn's movement state */
+	static EPlatformerGhostPose::Type GetPose (const APlatformerCharacter* Character);
+
+	int32 GetNumSamples () const {
+		return Samples.Num ();
+	}
+
+	float GetSampleInterval () const {
+		return SampleInterval;
+	}
+
+	bool SaveToFile (const FString& Filename) const;
+
+private:
+	float SampleInterval;
+	uint16 KeyframeInterval;
+
+	TArray<FPlatformerGhostKeyframe> Keyframes;
+	TArray<FPlatformerGhostSample> Samples;
+
+	/** quantized position of last sample, as playback will reconstruct it */
+	FIntVector LastPosition;
+};
+
+/**
+* Read only file contents, memory mapped where the platform allows it and loaded into memory otherwise.
+* Mapped pages are loaded by the OS on first access, so unused parts of a file cost nothing.
+*/
+class TORNADOTOWER_API FPlatformerMappedFile {
+public:
+	FPlatformerMappedFile ();
+	~FPlatformerMappedFile ();
+
+	bool Open (const FString& Filename);
+	void Close ();
+
+	const uint8* GetData () const {
+		return Data;
+	}
+
+	int64 GetSize () const {
+		return Size;
+	}
+
+	/** true if file is mapped, false if it was read into memory */
+	bool IsMapped () const {
+		return bMapped;
+	}
+
+private:
+	const uint8* Data;
+	int64 Size;
+	bool bMapped;
+
+	/** contents of file that couldn't be mapped */
+	TArray<uint8> Fallback;
+
+#if PLATFORM_WINDOWS
+	void* FileHandle;
+	void* MappingHandle;
+#endif
+
+	FPlatformerMappedFile (const FPlatformerMappedFile&);
+	FPlatformerMappedFile& operator= (const FPlatformerMappedFile&);
+};
+
+/** ghost file opened for playback ; samples are decoded straight from file memory */
+class TORNADOTOWER_API FPlatformerGhostTrack {
+public:
+	FPlatformerGhostTrack ();
+
+	/** opens and validates ghost file */
+	bool Open (const FString& Filename);
+
+	int32 GetNumSamples () const {
+		return Header ? Header->NumSamples : 0;
+	}
+
+	float GetDuration () const {
+		return Header ? Header->SampleInterval * FMath::Max<int32> (Header->NumSamples - 1, 0) : 0.0f;
+	}
+
+	const FPlatformerGhostHeader* GetHeader () const {
+		return Header;
+	}
+
+	const FPlatformerGhostKeyframe& GetKeyframe (int32 SampleIndex) const {
+		return Keyframes[SampleIndex / Header->KeyframeInterval];
+	}
+
+	const FPlatformerGhostSample& GetSample (int32 SampleIndex) const {
+		return Samples[SampleIndex];
+	}
+
+	bool IsMapped () const {
+		return File.IsMapped ();
+	}
+
+private:
+	FPlatformerMappedFile File;
+
+	const FPlatformerGhostHeader* Header;
+	const FPlatformerGhostKeyframe* Keyframes;
+	const FPlatformerGhostSample* Samples;
+};
+
+/**
+* Sequential decoder over FPlatformerGhostTrack.
+* Moving forward only adds deltas of skipped samples, moving backward restarts from nearest keyframe.
+*/
+class TORNADOTOWER_API FPlatformerGhostCursor {
+public:
+	FPlatformerGhostCursor ();
+
+	/** binds cursor to Track and moves it to first sample */
+	void Reset (const FPlatformerGhostTrack* InTrack);
+
+	/** returns interpolated transform and pose at Time from recording start ; holds last sample past the end */
+	void Evaluate (float Time, FVector& OutLocation, float& OutYaw, EPlatformerGhostPose::Type& OutPose);
+
+private:
+	const FPlatformerGhostTrack* Track;
+
+	/** sample cursor points at */
+	int32 SampleIndex;
+
+	/** quantized position of SampleIndex */
+	FIntVector Position;
+
+	/** moves cursor to given sample */
+	void Seek (int32 NewSampleIndex);
+};
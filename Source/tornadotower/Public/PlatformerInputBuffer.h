@@ -0,0 +1,49 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "tornadotower.h"
+
+/**
+* Button presses of a pawn with the time they happened, and movement basis of current control yaw.
+* Filled by input callbacks, read by UPlatformerPlayerMovementComp at the start of its tick,
+* so a press counts even if it arrived while pawn couldn't act on it yet.
+*/
+struct TORNADOTOWER_API FPlatformerInputBuffer {
+	FPlatformerInputBuffer ();
+
+	/** stores press time ; presses stay buffered until consumed or too old */
+	void PressJump (float Time);
+	void PressSlide (float Time);
+
+	/** returns true and forgets press if jump was pressed no longer than Window ago */
+	bool ConsumeJump (float Time, float Window);
+
+	/** returns true and forgets press if slide was pressed no longer than Window ago */
+	bool ConsumeSlide (float Time, float Window);
+
+	/** forgets all presses */
+	void Reset ();
+
+	/** recomputes Forward and Right if yaw changed since last call */
+	void UpdateYawBasis (float Yaw);
+
+	/** movement directions of control yaw passed to UpdateYawBasis */
+	const FVector& GetForward () const {
+		return Forward;
+	}
+
+	const FVector& GetRight () const {
+		return Right;
+	}
+
+private:
+	/** time of last unconsumed press, or -BIG_NUMBER */
+	float JumpPressTime;
+	float SlidePressTime;
+
+	/** yaw Forward and Right were computed for */
+	float BasisYaw;
+	FVector Forward;
+	FVector Right;
+};
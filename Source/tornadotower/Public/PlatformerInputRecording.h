@@ -0,0 +1,158 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "tornadotower.h"
+
+class APlatformerCharacter;
+
+/** input events stored in FPlatformerInputRecording */
+namespace EPlatformerInputEvent {
+	enum Type : uint8 {
+		/** MoveForward axis changed, value quantized to int8 */
+		MoveForward,
+		/** MoveRight axis changed, value quantized to int8 */
+		MoveRight,
+		Jump,
+		StopJumping,
+		StartSlide,
+		StopSlide,
+	};
+}
+
+/** single input event, stamped with frame index counted from recording start */
+struct FPlatformerInputEvent {
+	uint32 Frame;
+	uint8 Type;
+	int8 Value;
+
+	FPlatformerInputEvent ()
+		: Frame (0), Type (0), Value (0) {
+	}
+
+	FPlatformerInputEvent (uint32 InFrame, uint8 InType, int8 InValue)
+		: Frame (InFrame), Type (InType), Value (InValue) {
+	}
+
+	friend FArchive& operator<< (FArchive& Ar, FPlatformerInputEvent& Event) {
+		return Ar << Event.Frame << Event.Type << Event.Value;
+	}
+};
+
+/**
+* Input stream of one player pawn, recorded at fixed time step.
+* Axes are stored only when their value changes, so a recording costs 6 bytes per change.
+* Final pawn state is kept to check that replay ended up in the same place.
+*/
+class TORNADOTOWER_API FPlatformerInputRecording {
+public:
+	/** time step used for recording ; replay has to use the same */
+	float FixedDeltaTime;
+
+	/** number of recorded frames */
+	uint32 NumFrames;
+
+	/** pawn state when recording started */
+	FVector StartLocation;
+	FRotator StartRotation;
+	FRotator ControlRotation;
+
+	/** pawn state when recording ended */
+	FVector EndLocation;
+	FVector EndVelocity;
+
+	/** events ordered by frame */
+	TArray<FPlatformerInputEvent> Events;
+
+	FPlatformerInputRecording ();
+
+	/** quantizes axis value for storage */
+	static int8 QuantizeAxis (float Value) {
+		return (int8)FMath::RoundToInt (FMath::Clamp (Value, -1.0f, 1.0f) * 127.0f);
+	}
+
+	/** restores stored axis value */
+	static float DequantizeAxis (int8 Value) {
+		return Value / 127.0f;
+	}
+
+	bool SaveToFile (const FString& Filename) const;
+	bool LoadFromFile (const FString& Filename);
+
+	friend FArchive& operator<< (FArchive& Ar, FPlatformerInputRecording& Recording);
+};
+
+/** collects input of a pawn into FPlatformerInputRecording */
+class TORNADOTOWER_API FPlatformerInputRecorder {
+public:
+	FPlatformerInputRecorder ();
+
+	/** starts recording Character's input, saved to Filename on Stop */
+	void Start (APlatformerCharacter* Character, const FString& InFilename);
+
+	/** stores pawn's end state and writes recording to file */
+	void Stop (APlatformerCharacter* Character);
+
+	bool IsRecording () const {
+		return bRecording;
+	}
+
+	/** stores axis value if it changed since last frame */
+	void RecordAxis (EPlatformerInputEvent::Type Type, float Value);
+
+	/** stores button event */
+	void RecordAction (EPlatformerInputEvent::Type Type);
+
+private:
+	FPlatformerInputRecording Recording;
+	FString Filename;
+
+	/** GFrameCounter when recording started */
+	uint64 StartFrame;
+
+	/** last stored value of MoveForward and MoveRight */
+	int8 LastAxisValues[2];
+
+	bool bRecording;
+
+	uint32 GetFrame () const;
+};
+
+/**
+* Feeds FPlatformerInputRecording back into a pawn, one frame per tick,
+* and measures game thread time of every replayed frame.
+*/
+class TORNADOTOWER_API FPlatformerInputReplay {
+public:
+	FPlatformerInputReplay ();
+
+	/** loads recording and places Character at its start ; returns false if file couldn't be read */
+	bool Start (APlatformerCharacter* Character, const FString& Filename);
+
+	/** applies input for current frame ; returns false once recording has ended */
+	bool Tick (APlatformerCharacter* Character);
+
+	bool IsReplaying () const {
+		return bReplaying;
+	}
+
+	/** logs frame time percentiles and final pawn state, writes them as JSON to ReportFilename if set */
+	void Report (APlatformerCharacter* Character, const FString& ReportFilename) const;
+
+private:
+	FPlatformerInputRecording Recording;
+
+	/** GFrameCounter when replay started */
+	uint64 StartFrame;
+
+	/** next event to apply */
+	int32 NextEvent;
+
+	/** current value of MoveForward and MoveRight */
+	float AxisValues[2];
+
+	/** game thread time of replayed frames, in ms */
+	TArray<float> FrameTimes;
+
+	bool bReplaying;
+};
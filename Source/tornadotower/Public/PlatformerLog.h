@@ -0,0 +1,18 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "tornadotower.h"
+
+DECLARE_LOG_CATEGORY_EXTERN (LogPlatformer, Log, All);
+
+/**
+* Log for input and per-frame paths. Compiled out of shipping builds, and arguments aren't formatted
+* unless LogPlatformer is raised to given verbosity (use Verbose or VeryVerbose).
+* For data needed in shipping builds use PLATFORMER_TRACE.
+*/
+#if UE_BUILD_SHIPPING
+	#define PLATFORMER_HOT_LOG(Verbosity, Format, ...)
+#else
+	#define PLATFORMER_HOT_LOG(Verbosity, Format, ...) UE_LOG (LogPlatformer, Verbosity, Format, ##__VA_ARGS__)
+#endif
@@ -0,0 +1,84 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "tornadotower.h"
+
+/** pawn movement state at given time */
+struct FPlatformerMovementSnapshot {
+	/** time of snapshot: client time stamp for remotely controlled pawns, world time otherwise */
+	float Timestamp;
+
+	/** pawn location */
+	FVector Location;
+
+	/** pawn velocity */
+	FVector Velocity;
+
+	/** unscaled capsule half height */
+	float CapsuleHalfHeight;
+
+	/** EMovementMode */
+	uint8 MovementMode;
+
+	/** true when pawn was sliding */
+	uint8 bSliding : 1;
+
+	FPlatformerMovementSnapshot ()
+		: Timestamp (0.0f), Location (ForceInitToZero), Velocity (ForceInitToZero), CapsuleHalfHeight (0.0f), MovementMode (MOVE_None), bSliding (false) {
+	}
+};
+
+/**
+* Fixed size ring buffer of movement snapshots with increasing timestamps.
+* Storage is allocated once in Init, recording and sampling never allocate.
+*/
+class TORNADOTOWER_API FPlatformerMovementHistory {
+public:
+	FPlatformerMovementHistory ();
+
+	/** allocates storage for Capacity snapshots and clears history */
+	void Init (int32 Capacity);
+
+	/** returns true if storage was allocated */
+	bool IsInitialized () const {
+		return Snapshots.Num () > 0;
+	}
+
+	/** clears history, keeping storage */
+	void Reset ();
+
+	/** stores snapshot, overwriting the oldest one when full ; history restarts when timestamp goes back */
+	void Record (const FPlatformerMovementSnapshot& Snapshot);
+
+	/**
+	* returns state at given time, interpolated between surrounding snapshots
+	* returns false if history is empty or doesn't cover Timestamp: state past the newest snapshot isn't known yet
+	*/
+	bool Sample (float Timestamp, FPlatformerMovementSnapshot& OutSnapshot) const;
+
+	/** returns true if Timestamp is later than the newest snapshot, or history is empty */
+	bool IsAfterNewest (float Timestamp) const {
+		return Count == 0 || Timestamp > GetOrdered (Count - 1).Timestamp;
+	}
+
+	/** returns number of stored snapshots */
+	int32 Num () const {
+		return Count;
+	}
+
+private:
+	/** ring storage */
+	TArray<FPlatformerMovementSnapshot> Snapshots;
+
+	/** index of next snapshot to write */
+	int32 Head;
+
+	/** number of valid snapshots */
+	int32 Count;
+
+	/** returns snapshot by age order, 0 being the oldest */
+	FORCEINLINE const FPlatformerMovementSnapshot& GetOrdered (int32 Index) const {
+		return Snapshots[(Head - Count + Index + Snapshots.Num ()) % Snapshots.Num ()];
+	}
+};
@@ -0,0 +1,96 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "tornadotower.h"
+#include "GameFramework/Info.h"
+#include "PlatformerSpatialHash.h"
+#include "PlatformerObstacleIndex.generated.h"
+
+/** obstacle height types matching climb over animations */
+UENUM()
+enum class EPlatformerObstacleClass : uint8 {
+	Small,
+	Mid,
+	Big
+};
+
+/** top surface of a static obstacle, baked by PlatformerObstacleIndex commandlet */
+USTRUCT()
+struct FPlatformerObstacleTop {
+	GENERATED_USTRUCT_BODY()
+
+	/** minimal XY corner of top surface */
+	UPROPERTY ()
+	FVector2D Min;
+
+	/** maximal XY corner of top surface */
+	UPROPERTY ()
+	FVector2D Max;
+
+	/** world Z of top surface */
+	UPROPERTY ()
+	float TopZ;
+
+	/** world Z of obstacle base */
+	UPROPERTY ()
+	float BottomZ;
+
+	/** component the top was baked from */
+	UPROPERTY ()
+	TWeakObjectPtr<UPrimitiveComponent> Component;
+
+	FPlatformerObstacleTop ()
+		: Min (ForceInitToZero), Max (ForceInitToZero), TopZ (0.0f), BottomZ (0.0f) {
+	}
+
+	FBox GetBox () const {
+		return FBox (FVector (Min, BottomZ), FVector (Max, TopZ));
+	}
+};
+
+/**
+* Baked index of climbable obstacle tops in a level.
+* Answers "what is the top of the obstacle at this point" with a single grid cell lookup,
+* replacing the line trace used to classify vaults. Only static geometry is indexed.
+*/
+UCLASS(notplaceable)
+class TORNADOTOWER_API APlatformerObstacleIndex : public AInfo {
+	GENERATED_UCLASS_BODY()
+public:
+
+	/** builds lookup grid from baked data */
+	virtual void PostInitializeComponents () override;
+
+	/** returns index placed in world, or nullptr if level wasn't baked */
+	static APlatformerObstacleIndex* Get (UWorld* World);
+
+	/** replaces baked data and rebuilds lookup grid */
+	void SetObstacles (const TArray<FPlatformerObstacleTop>& InObstacles, float InCellSize);
+
+	/**
+	* finds highest obstacle top containing Location in XY plane with top between MinZ and MaxZ
+	* returns true and fills OutTop if found
+	*/
+	bool FindObstacleTop (const FVector& Location, float MinZ, float MaxZ, FPlatformerObstacleTop& OutTop) const;
+
+	/** returns number of baked obstacles */
+	int32 GetNumObstacles () const {
+		return Obstacles.Num ();
+	}
+
+private:
+	/** baked obstacle tops */
+	UPROPERTY ()
+	TArray<FPlatformerObstacleTop> Obstacles;
+
+	/** cell size used for lookup grid */
+	UPROPERTY ()
+	float CellSize;
+
+	/** lookup grid, indices into Obstacles */
+	FPlatformerSpatialHash Grid;
+
+	/** fills Grid from Obstacles */
+	void BuildGrid ();
+};
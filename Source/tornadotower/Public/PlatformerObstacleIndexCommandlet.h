@@ -0,0 +1,26 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "tornadotower.h"
+#include "Commandlets/Commandlet.h"
+#include "PlatformerObstacleIndexCommandlet.generated.h"
+
+/**
+* Bakes climbable obstacle tops of a map into APlatformerObstacleIndex and saves the map.
+* Run before cooking.
+*
+* Usage:
+*   -run=PlatformerObstacleIndex -Map=/Game/Maps/MyMap
+*                                [-MinHeight=30] [-MaxHeight=400] [-MaxFootprint=2000] [-CellSize=400]
+*
+* Indexed: static primitives blocking pawns whose collision is a single box along world axes, with height
+* in [MinHeight, MaxHeight] and XY size below MaxFootprint (larger ones are floors). Obstacle classes are
+* picked at vault time from climbing pawn's heights.
+*/
+UCLASS()
+class UPlatformerObstacleIndexCommandlet : public UCommandlet {
+	GENERATED_UCLASS_BODY()
+
+	virtual int32 Main (const FString& Params) override;
+};
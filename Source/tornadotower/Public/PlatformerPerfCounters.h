@@ -0,0 +1,118 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "tornadotower.h"
+
+DECLARE_STATS_GROUP (TEXT ("Platformer"), STATGROUP_Platformer, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN (TEXT ("Movement Tick"), STAT_PlatformerMovementTick, STATGROUP_Platformer, TORNADOTOWER_API);
+DECLARE_CYCLE_STAT_EXTERN (TEXT ("PhysWalking"), STAT_PlatformerPhysWalking, STATGROUP_Platformer, TORNADOTOWER_API);
+DECLARE_CYCLE_STAT_EXTERN (TEXT ("Update Slide Velocity"), STAT_PlatformerUpdateSlideVelocity, STATGROUP_Platformer, TORNADOTOWER_API);
+DECLARE_CYCLE_STAT_EXTERN (TEXT ("Restore Height After Slide"), STAT_PlatformerRestoreCollisionHeight, STATGROUP_Platformer, TORNADOTOWER_API);
+DECLARE_CYCLE_STAT_EXTERN (TEXT ("Character Tick"), STAT_PlatformerCharacterTick, STATGROUP_Platformer, TORNADOTOWER_API);
+DECLARE_CYCLE_STAT_EXTERN (TEXT ("Climb Over Obstacle"), STAT_PlatformerClimbOverObstacle, STATGROUP_Platformer, TORNADOTOWER_API);
+DECLARE_CYCLE_STAT_EXTERN (TEXT ("Move Blocked By"), STAT_PlatformerMoveBlockedBy, STATGROUP_Platformer, TORNADOTOWER_API);
+DECLARE_CYCLE_STAT_EXTERN (TEXT ("Collision Queries"), STAT_PlatformerCollisionQuery, STATGROUP_Platformer, TORNADOTOWER_API);
+DECLARE_CYCLE_STAT_EXTERN (TEXT ("Batch Movement"), STAT_PlatformerBatchMovement, STATGROUP_Platformer, TORNADOTOWER_API);
+DECLARE_CYCLE_STAT_EXTERN (TEXT ("Crowd Tick"), STAT_PlatformerCrowdTick, STATGROUP_Platformer, TORNADOTOWER_API);
+
+DECLARE_DWORD_COUNTER_STAT_EXTERN (TEXT ("Slide Starts"), STAT_PlatformerSlideStarts, STATGROUP_Platformer, TORNADOTOWER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN (TEXT ("Slide Ends"), STAT_PlatformerSlideEnds, STATGROUP_Platformer, TORNADOTOWER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN (TEXT ("Overlap Tests"), STAT_PlatformerOverlaps, STATGROUP_Platformer, TORNADOTOWER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN (TEXT ("Traces"), STAT_PlatformerTraces, STATGROUP_Platformer, TORNADOTOWER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN (TEXT ("Capsule Resizes"), STAT_PlatformerCapsuleResizes, STATGROUP_Platformer, TORNADOTOWER_API);
+
+/** timed scopes of FPlatformerPerfCounters, each matching STAT_Platformer<Name> */
+namespace EPlatformerCycleCounter {
+	enum Type {
+		/** whole movement component tick, including collision it does */
+		MovementTick,
+		PhysWalking,
+		UpdateSlideVelocity,
+		RestoreCollisionHeight,
+		CharacterTick,
+		ClimbOverObstacle,
+		MoveBlockedBy,
+		/** explicit collision queries made by platformer code: slide exit overlaps, climb traces, obstacle lookups */
+		CollisionQuery,
+		/** game thread time of batched movement, including wait for its worker tasks */
+		BatchMovement,
+		/** simulation and instance updates of APlatformerCrowd runners */
+		CrowdTick,
+		Num
+	};
+}
+
+/** counted events of FPlatformerPerfCounters, each matching STAT_Platformer<Name> */
+namespace EPlatformerCallCounter {
+	enum Type {
+		SlideStarts,
+		SlideEnds,
+		Overlaps,
+		Traces,
+		CapsuleResizes,
+		Num
+	};
+}
+
+/**
+* Game thread cycles and event counts of platformer code, summed over all characters until Reset.
+* Same scopes feed STATGROUP_Platformer, these counters are kept for tools that need the values
+* per frame without stats system: crowd stress commandlet and Platformer.CsvCapture.
+* Cycles are counted only while bEnabled is set.
+*/
+struct TORNADOTOWER_API FPlatformerPerfCounters {
+	/** true while scopes add their cycles */
+	static bool bEnabled;
+
+	/** cycles per EPlatformerCycleCounter */
+	static uint32 Cycles[EPlatformerCycleCounter::Num];
+
+	/** events per EPlatformerCallCounter */
+	static uint32 Calls[EPlatformerCallCounter::Num];
+
+	/** clears all counters */
+	static void Reset ();
+
+	/** returns readable counter names, used as CSV columns */
+	static const TCHAR* GetCycleCounterName (EPlatformerCycleCounter::Type Counter);
+	static const TCHAR* GetCallCounterName (EPlatformerCallCounter::Type Counter);
+
+	/** returns value at given percentile (0..1) of sorted array */
+	static float GetPercentile (const TArray<float>& Sorted, float Percentile);
+};
+
+/** adds cycles spent in scope to given counter, while counting is enabled */
+class FPlatformerScopeCycleCounter {
+public:
+	FORCEINLINE FPlatformerScopeCycleCounter (uint32& InCounter)
+		: Counter (FPlatformerPerfCounters::bEnabled ? &InCounter : NULL)
+		, StartCycles (Counter ? FPlatformTime::Cycles () : 0) {
+	}
+
+	FORCEINLINE ~FPlatformerScopeCycleCounter () {
+		if (Counter) {
+			*Counter += FPlatformTime::Cycles () - StartCycles;
+		}
+	}
+
+private:
+	uint32* Counter;
+	uint32 StartCycles;
+};
+
+/** times enclosing scope in STAT_Platformer<Name> and FPlatformerPerfCounters */
+#define PLATFORMER_SCOPE_CYCLE_COUNTER(Name) \
+	SCOPE_CYCLE_COUNTER (STAT_Platformer##Name); \
+	FPlatformerScopeCycleCounter PlatformerCycleCounter_##Name (FPlatformerPerfCounters::Cycles[EPlatformerCycleCounter::Name])
+
+/** counts event in STAT_Platformer<Name> and FPlatformerPerfCounters */
+#define PLATFORMER_INC_CALL_COUNTER(Name) \
+	INC_DWORD_STAT (STAT_Platformer##Name); \
+	FPlatformerPerfCounters::Calls[EPlatformerCallCounter::Name]++
+
+/** counts Amount events in STAT_Platformer<Name> and FPlatformerPerfCounters */
+#define PLATFORMER_ADD_CALL_COUNTER(Name, Amount) \
+	INC_DWORD_STAT_BY (STAT_Platformer##Name, Amount); \
+	FPlatformerPerfCounters::Calls[EPlatformerCallCounter::Name] += (Amount)
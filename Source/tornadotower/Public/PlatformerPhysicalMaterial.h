@@ -0,0 +1,24 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "tornadotower.h"
+#include "PhysicalMaterials/PhysicalMaterial.h"
+#include "PlatformerPhysicalMaterial.generated.h"
+
+/**
+* Physical material with slide response of a surface (ice, metal, mud).
+* Floors using other physical materials slide with default coefficients.
+*/
+UCLASS()
+class TORNADOTOWER_API UPlatformerPhysicalMaterial : public UPhysicalMaterial {
+	GENERATED_UCLASS_BODY()
+public:
+	/** scales speed loss of pawns sliding on flat ground or uphill */
+	UPROPERTY (EditAnywhere, Category = Slide, meta = (ClampMin = "0.0"))
+		float SlideFrictionScale;
+
+	/** scales speed gain of pawns sliding downhill */
+	UPROPERTY (EditAnywhere, Category = Slide, meta = (ClampMin = "0.0"))
+		float SlideAccelerationScale;
+};
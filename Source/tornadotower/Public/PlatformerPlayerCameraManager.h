@@ -0,0 +1,58 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "tornadotower.h"
+#include "Camera/PlayerCameraManager.h"
+#include "PlatformerPlayerCameraManager.generated.h"
+
+/**
+* Third person camera of platformer pawns, replacing per-frame spring arm update.
+* Camera height stays locked to the ground while pawn is in the air and follows only past pawn's CameraHeightChangeThreshold.
+* Arm length and probe settings are read from pawn's camera boom, which has its own collision test disabled ;
+* collision probe runs only after pivot or view rotation changed enough to matter, otherwise last result is reused.
+*/
+UCLASS()
+class TORNADOTOWER_API APlatformerPlayerCameraManager : public APlayerCameraManager {
+	GENERATED_UCLASS_BODY()
+public:
+
+	/** computes camera for platformer pawns, other view targets use default behavior */
+	virtual void UpdateViewTargetInternal (FTViewTarget& OutVT, float DeltaTime) override;
+
+protected:
+	/** how fast camera height catches up with pawn walking on ground */
+	UPROPERTY (EditDefaultsOnly, Category = Camera)
+		float HeightInterpSpeed;
+
+	/** lateral pivot movement that triggers new collision probe */
+	UPROPERTY (EditDefaultsOnly, Category = Camera)
+		float ProbeMinMove;
+
+	/** view rotation change, in degrees, that triggers new collision probe */
+	UPROPERTY (EditDefaultsOnly, Category = Camera)
+		float ProbeMinAngle;
+
+	/** updates CameraBaseZ from pawn height */
+	void UpdateCameraHeight (const class APlatformerCharacter* MyPawn, float DeltaTime);
+
+	/** returns true if pivot or view rotation moved far enough from last collision probe */
+	bool NeedsCollisionProbe (const FVector& Pivot, const FRotator& ViewRotation) const;
+
+private:
+	/** view target camera state belongs to */
+	TWeakObjectPtr<AActor> CameraTarget;
+
+	/** world Z camera pivot is locked to */
+	float CameraBaseZ;
+
+	/** pivot and view rotation of last collision probe */
+	FVector LastProbePivot;
+	FRotator LastProbeRotation;
+
+	/** fraction of arm length left free by last collision probe */
+	float ProbeArmFraction;
+
+	/** true when last collision probe is valid for CameraTarget */
+	uint32 bHasProbe : 1;
+};
@@ -4,13 +4,67 @@
 
 #include "tornadotower.h"
 #include "GameFramework/CharacterMovementComponent.h"
+#include "PlatformerMovementHistory.h"
+#include "PlatformerClimbMarker.h"
 #include "PlatformerPlayerMovementComp.generated.h"
 
+class APlatformerBatchMovementManager;
+struct FPlatformerBatchMove;
+
+/** movement detail level */
+UENUM()
+enum class EPlatformerMovementLOD : uint8 {
+	/** ticks every frame */
+	Full,
+	/** ticks at ReducedLODTickInterval, slide integrated with fixed substeps */
+	Reduced
+};
+
+/** custom movement modes of UPlatformerPlayerMovementComp, stored in CustomMovementMode */
+UENUM()
+enum class EPlatformerCustomMovementMode : uint8 {
+	None,
+	/** running into obstacle and climbing over it, or climbing to ledge grabbed in mid air, see EPlatformerVaultState */
+	Vault
+};
+
+/** steps of vault */
+UENUM()
+enum class EPlatformerVaultState : uint8 {
+	None,
+	/** pawn stopped at obstacle, playing hit reaction */
+	HitReaction,
+	/** pawn follows root motion of climb animation, obstacle is ignored by sweeps */
+	Climb,
+	/** pawn was placed on top of grabbed ledge, waits for climb animation to finish */
+	LedgeClimb
+};
+
 UCLASS()
 class TORNADOTOWER_API UPlatformerPlayerMovementComp : public UCharacterMovementComponent {
 	GENERATED_UCLASS_BODY()
+
+	friend class UPlatformerBenchmarkCommandlet;
+	friend class UPlatformerCrowdStressCommandlet;
+	friend class APlatformerCrowd;
+	friend class FSavedMove_Platformer;
 public:
 
+	/** caches standing collision used to leave slide */
+	virtual void InitializeComponent () override;
+
+	/** caches climb marker registry used by ledge grab, joins movement batch if enabled */
+	virtual void BeginPlay () override;
+
+	/** leaves movement batch */
+	virtual void EndPlay (const EEndPlayReason::Type EndPlayReason) override;
+
+	/** caches per-frame values used by slide update, applies buffered input before movement runs */
+	virtual void TickComponent (float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	/** creates prediction data carrying slide state in saved moves */
+	virtual class FNetworkPredictionData_Client* GetPredictionData_Client () const override;
+
 	/** stop slide when falling */
 	virtual void StartFalling (int32 Iterations, float remainingTime, float timeTick, const FVector& Delta, const FVector& subLoc) override;
 
@@ -20,28 +74,146 @@ public:
 	/** attempts to end slide move - fails if collisions above pawn don't allow it */
 	void TryToEndSlide ();
 
-	/** stop movement and save current speed with obstacle modifier */
-	void PauseMovementForObstacleHit ();
+	/** ends slide at once and clears movement history, pending look-ahead sweep and buffered input ; pawn must already be at its standing start location */
+	void ResetForRound ();
+
+	/**
+	* stops pawn at obstacle, saving current speed with obstacle modifier, and starts vault
+	* climb starts after HitReactionTime, or right away if it is zero
+	* bLookAhead vaults were started before impact and keep speed with look-ahead modifier instead
+	*/
+	void StartVault (UPrimitiveComponent* Obstacle, float HitReactionTime, bool bLookAhead = false);
+
+	/** returns true while vault is in progress */
+	bool IsVaulting () const;
 
-	/** stop movement and save current speed with ledge grab modifier */
-	void PauseMovementForLedgeGrab ();
+	/** returns true if pawn ran off a ledge no longer than CoyoteTime ago and hasn't jumped since */
+	bool IsInCoyoteTime () const;
+
+	/** marks coyote time as used */
+	virtual bool DoJump (bool bReplayingMoves) override;
+
+	/** stops pawn in mid air, saving current speed with ledge grab modifier, and climbs to Marker */
+	void StartLedgeGrab (APlatformerClimbMarker* Marker);
 
 	/** restore movement and saved speed */
 	void RestoreMovement ();
 
+	/** returns current movement detail level */
+	EPlatformerMovementLOD GetMovementLOD () const;
+
+	/** records remote client's move into movement history */
+	virtual void MoveAutonomous (float ClientTimeStamp, float DeltaTime, uint8 CompressedFlags, const FVector& NewAccel) override;
+
+	/** stores current movement state in movement history ; allocates history on first call */
+	void RecordMovementSnapshot (float Timestamp);
+
+	/**
+	* returns server side movement state at given time stamp
+	* uses client time stamps for remotely controlled pawns, world time otherwise
+	*/
+	bool GetMovementSnapshot (float Timestamp, FPlatformerMovementSnapshot& OutSnapshot) const;
+
+	/** returns time stamp of move currently simulated by owning client */
+	float GetClientMoveTimeStamp () const;
+
+	/** returns true if server hasn't simulated owning client's move of given time stamp yet */
+	bool IsClientMoveAhead (float ClientTimeStamp) const;
+
+	/**
+	* sweeps pawn capsule of given unscaled half height from Location along Direction, shrunk by step height like look-ahead sweep
+	* returns true if it hits a wall facing the run within Distance
+	*/
+	bool FindObstacleAhead (const FVector& Location, float CapsuleHalfHeight, const FVector& Direction, float Distance, FHitResult& OutHit) const;
+
+	/** sets bUseBatchMovement, joining or leaving movement batch of current world */
+	void SetUseBatchMovement (bool bUse);
+
+	/** sets bEnableMovementLOD ; disabling it returns pawn to full movement LOD right away */
+	void SetMovementLODEnabled (bool bEnable);
+
+	/** returns true if batch can move pawn this frame: walking AI runner on static floor, nothing but running or sliding */
+	bool CanUseBatchMovement () const;
+
+	/** game thread part of batched move: consumes input, starts slide and fills Move */
+	void PrepareBatchMove (float DeltaTime, FPlatformerBatchMove& Move);
+
+	/**
+	* integrates velocity and sweeps capsule along it, storing new location and hits in Move
+	* touches only this component's velocity and slide state and queries the world, so it can run on any thread
+	*/
+	void SimulateBatchMove (FPlatformerBatchMove& Move);
+
+	/**
+	* game thread part of batched move: sweeps capsule to simulated location, steps up or reports impact and updates floor
+	* then rotates pawn and calls movement updated callbacks as PerformMovement would ; own tick skips movement this frame
+	*/
+	void ApplyBatchMove (const FPlatformerBatchMove& Move);
+
 protected:
 
-	/** update slide */
+	/** update slide and look-ahead sweep */
 	virtual void PhysWalking (float deltaTime, int32 Iterations) override;
 
+	/**
+	* vaults obstacles found by look-ahead sweep before they are hit
+	* issues next look-ahead sweep, read back next frame
+	*/
+	void UpdateLookAheadSweep (float DeltaTime);
+
+	/** returns true if look-ahead sweep should run for this pawn */
+	bool CanUseLookAheadSweep () const;
+
+	/** returns capsule of given scaled half height shrunk by step height, so steps and floor don't count as obstacles, and offset of its center */
+	FCollisionShape GetObstacleSweepShape (float CapsuleHalfHeight, FVector& OutCenterOffset) const;
+
+	/** collision params of obstacle sweeps: geometry blocking pawn is reported as overlaps, so sweep doesn't stop at a step or ramp in front of a wall */
+	void InitObstacleSweepParams (FCollisionQueryParams& QueryParams, FCollisionResponseParams& ResponseParams) const;
+
+	/** returns true if hit of obstacle sweep is a non walkable surface blocking pawn and facing the run */
+	bool IsObstacleHit (const FHitResult& Hit) const;
+
+	/** re-arms jump and slide pressed recently, once pawn can act on them ; locally controlled pawns only */
+	void ApplyBufferedInput ();
+
+	/** grabs ledges in reach before every falling step */
+	virtual void PhysFalling (float deltaTime, int32 Iterations) override;
+
+	/** returns climb marker with its grab point in reach of pawn's hands, or NULL */
+	APlatformerClimbMarker* FindLedgeInReach () const;
+
+	/** runs custom movement modes */
+	virtual void PhysCustom (float deltaTime, int32 Iterations) override;
+
+	/** clears vault state when leaving vault mode */
+	virtual void OnMovementModeChanged (EMovementMode PreviousMovementMode, uint8 PreviousCustomMode) override;
+
+	/** advances vault state machine */
+	void PhysVault (float deltaTime, int32 Iterations);
+
+	/** asks pawn to climb over obstacle, finishes vault if there is nothing to climb */
+	void StartVaultClimb ();
+
+	/** restores walking and saved speed */
+	void FinishVault ();
+
+	/** unpacks slide input and client slide state from saved move flags */
+	virtual void UpdateFromCompressedFlags (uint8 Flags) override;
+
 	/** force movement */
 	//virtual FVector ScaleInputAcceleration (const FVector& InputAcceleration) const override;
 
-	/** calculates OutVelocity which is new velocity for pawn during slide */
-	void CalcSlideVelocity (FVector& OutVelocity) const;
+	/** while pawn is sliding updates CurrentSlideVelocityReduction and Velocity using FPlatformerSlideKernel */
+	void UpdateSlideVelocity (float DeltaTime);
+
+	/** slide kernel steps of UpdateSlideVelocity, without game thread only surface lookup */
+	void IntegrateSlide (const FVector& FloorNormal, float DeltaTime, bool bFixedStep);
 
-	/** while pawn is sliding calculates new value of CurrentSlideVelocityReduction */
-	void CalcCurrentSlideVelocityReduction (float DeltaTime);
+	/** returns true if slide is integrated with SlideFixedTimeStep substeps: in reduced movement LOD and for client predicted pawns */
+	bool UsesFixedSlideStep () const;
+
+	/** resolves slide coefficients of floor's physical material, only when floor component changes */
+	void UpdateSlideSurface ();
 
 	/** handles pawn slide move */
 	void HandleSlide (float DeltaTime);
@@ -49,6 +221,9 @@ protected:
 	/** forces pawn to start sliding */
 	void StartSlide ();
 
+	/** stores current capsule size and mesh offset as standing values restored after slide */
+	void CacheStandingCollision ();
+
 	/** changes pawn height to SlideHeight and adjusts pawn collisions */
 	void SetSlideCollisionHeight ();
 
@@ -58,6 +233,23 @@ protected:
 	*/
 	bool RestoreCollisionHeightAfterSlide ();
 
+	/**
+	* returns true if geometry that blocked the last slide exit test still blocks default capsule at given location
+	* blockers are considered still in the way while they haven't moved, capsule bounds overlap their recorded bounds
+	* and pawn is within a radius of where the test failed ; bounds of big meshes say little, so at most
+	* MaxSlideExitTestsSkipped tests are skipped in a row
+	*/
+	bool IsSlideExitStillBlocked (const FVector& Location, float Radius, float HalfHeight) const;
+
+	/** forgets geometry recorded by failed slide exit test */
+	void ClearSlideExitBlockers ();
+
+	/** picks movement LOD from distance to player views and visibility */
+	void UpdateMovementLOD ();
+
+	/** switches movement LOD and adjusts tick rate */
+	void SetMovementLOD (EPlatformerMovementLOD NewLOD);
+
 private:
 
 	/** speed multiplier after hiting an obstacle */
@@ -68,6 +260,34 @@ private:
 	UPROPERTY (EditDefaultsOnly, Category = Config)
 		float ModSpeedLedgeGrab;
 
+	/** speed multiplier after vault started by look-ahead sweep */
+	UPROPERTY (EditDefaultsOnly, Category = Config)
+		float ModSpeedLookAheadVault;
+
+	/** true if running pawns look for obstacles ahead, vaulting them without stopping */
+	UPROPERTY (EditDefaultsOnly, Category = LookAhead)
+		uint32 bEnableLookAheadVault : 1;
+
+	/** minimal speed for look-ahead sweep, slower pawns vault after hitting obstacles */
+	UPROPERTY (EditDefaultsOnly, Category = LookAhead)
+		float LookAheadMinSpeed;
+
+	/** number of frames of travel covered by look-ahead sweep */
+	UPROPERTY (EditDefaultsOnly, Category = LookAhead)
+		float LookAheadFrames;
+
+	/** how long a jump press is kept before pawn can jump, e.g. pressed right before landing */
+	UPROPERTY (EditDefaultsOnly, Category = Input)
+		float JumpBufferTime;
+
+	/** how long a slide press is kept before pawn can slide */
+	UPROPERTY (EditDefaultsOnly, Category = Input)
+		float SlideBufferTime;
+
+	/** how long after running off a ledge pawn can still jump */
+	UPROPERTY (EditDefaultsOnly, Category = Input)
+		float CoyoteTime;
+
 	/** value by which speed will be reduced during slide */
 	UPROPERTY (EditDefaultsOnly, Category = Config)
 		float SlideVelocityReduction;
@@ -84,12 +304,127 @@ private:
 	UPROPERTY (EditDefaultsOnly, Category = Config)
 		float SlideHeight;
 
+	/** true if pawns not controlled by players can drop to reduced movement LOD */
+	UPROPERTY (EditDefaultsOnly, Category = LOD)
+		uint32 bEnableMovementLOD : 1;
+
+	/** distance from closest player view above which pawn uses reduced movement LOD */
+	UPROPERTY (EditDefaultsOnly, Category = LOD)
+		float ReducedLODDistance;
+
+	/** time without being rendered after which pawn uses reduced movement LOD */
+	UPROPERTY (EditDefaultsOnly, Category = LOD)
+		float ReducedLODNotRenderedTime;
+
+	/** tick interval of reduced movement LOD */
+	UPROPERTY (EditDefaultsOnly, Category = LOD)
+		float ReducedLODTickInterval;
+
+	/** how often movement LOD is evaluated */
+	UPROPERTY (EditDefaultsOnly, Category = LOD)
+		float MovementLODCheckInterval;
+
+	/** fixed time step used to integrate slide in reduced movement LOD and for client predicted pawns */
+	UPROPERTY (EditDefaultsOnly, Category = LOD)
+		float SlideFixedTimeStep;
+
+	/** how far in front of capsule pawn can grab a ledge */
+	UPROPERTY (EditDefaultsOnly, Category = Config)
+		float LedgeGrabReachForward;
+
+	/** how far above capsule top pawn can grab a ledge */
+	UPROPERTY (EditDefaultsOnly, Category = Config)
+		float LedgeGrabReachUp;
+
+	/** time before end of climb animation at which walking is restored */
+	UPROPERTY (EditDefaultsOnly, Category = Config)
+		float VaultClimbEndTime;
+
+	/** true if AI controlled pawn is moved by APlatformerBatchMovementManager together with other runners */
+	UPROPERTY (EditDefaultsOnly, Category = Batch)
+		uint32 bUseBatchMovement : 1;
+
+	/** number of movement snapshots kept on server for lag compensation */
+	UPROPERTY (EditDefaultsOnly, Category = Network)
+		int32 MovementHistorySize;
+
 	/** offset value, by which relative location of pawn mesh needs to be changed, when pawn is sliding */
 	FVector SlideMeshRelativeLocationOffset;
 
+	/** unscaled capsule size of standing pawn */
+	float StandingRadius;
+	float StandingHalfHeight;
+
+	/** standing capsule, prebuilt for slide exit test */
+	FCollisionShape StandingCollisionShape;
+
+	/** mesh relative location of standing pawn */
+	FVector StandingMeshRelativeLocation;
+
+	/** blocking components found by last failed slide exit test */
+	TArray<TWeakObjectPtr<UPrimitiveComponent>, TInlineAllocator<4>> SlideExitBlockers;
+
+	/** combined bounds of SlideExitBlockers when they were recorded */
+	FBox SlideExitBlockersBounds;
+
+	/** location of capsule tested by last failed slide exit test */
+	FVector SlideExitBlockedLocation;
+
+	/** slide exit tests skipped since last query */
+	int32 NumSlideExitTestsSkipped;
+
+	/** results of slide exit test, kept so queries reuse its allocation */
+	TArray<FOverlapResult> SlideExitOverlaps;
+
+	/** floor component slide coefficients were resolved for */
+	TWeakObjectPtr<UPrimitiveComponent> SlideSurfaceComponent;
+
+	/** UPlatformerPhysicalMaterial scales of SlideSurfaceComponent, 1 for other materials */
+	float SlideSurfaceFrictionScale;
+	float SlideSurfaceAccelerationScale;
+
 	/** value by which sliding pawn speed is currently being reduced */
 	float CurrentSlideVelocityReduction;
 
+	/** effective world time dilation, cached once per tick */
+	float CachedTimeDilation;
+
+	/** slide time not yet integrated by fixed steps */
+	float SlideTimeAccumulator;
+
+	/** time left until next movement LOD evaluation */
+	float MovementLODCheckTimeLeft;
+
+	/** current movement detail level */
+	EPlatformerMovementLOD MovementLOD;
+
+	/** recent movement states, recorded on server only */
+	FPlatformerMovementHistory MovementHistory;
+
+	/** current step of vault */
+	EPlatformerVaultState VaultState;
+
+	/** time left in current vault step */
+	float VaultStateTimeLeft;
+
+	/** obstacle ignored by sweeps during vault */
+	TWeakObjectPtr<UPrimitiveComponent> VaultIgnoredComponent;
+
+	/** pending look-ahead sweep, results are available next frame */
+	FTraceHandle LookAheadTraceHandle;
+
+	/** GFrameCounter of last look-ahead sweep */
+	uint64 LookAheadTraceFrame;
+
+	/** batch pawn is registered with */
+	TWeakObjectPtr<APlatformerBatchMovementManager> BatchMovementManager;
+
+	/** climb markers of current world */
+	TWeakObjectPtr<APlatformerClimbMarkerRegistry> ClimbMarkerRegistry;
+
+	/** time spent falling since pawn last walked */
+	float TimeSinceGrounded;
+
 	/** saved modified value of speed to restore after animation finish */
 	float SavedSpeed;
 
@@ -98,4 +433,63 @@ private:
 
 	/** true if pawn needs to use SlideMeshRelativeLocationOffset while sliding */
 	uint32 bWantsSlideMeshRelativeLocationOffset : 1;
+
+	/** true if pawn jumped since it last walked, coyote time doesn't apply */
+	uint32 bJumpedSinceGrounded : 1;
+
+	/** true if slide was pressed recently enough to start it this tick */
+	uint32 bBufferedSlide : 1;
+
+	/** true if batch already moved pawn this frame */
+	uint32 bMovedByBatch : 1;
+};
+
+/**
+* Saved move with slide input and slide state.
+* Slide input and state travel to the server as two of the custom compressed flags,
+* slide integration state is kept locally for replaying moves after a correction.
+*/
+class FSavedMove_Platformer : public FSavedMove_Character {
+public:
+	typedef FSavedMove_Character Super;
+
+	/** slide button is held */
+	static const uint8 FLAG_WantsToSlide = FLAG_Custom_0;
+
+	/** client was sliding when move started */
+	static const uint8 FLAG_InSlide = FLAG_Custom_1;
+
+	FSavedMove_Platformer ();
+
+	virtual void Clear () override;
+	virtual uint8 GetCompressedFlags () const override;
+	virtual bool CanCombineWith (const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const override;
+	virtual void SetMoveFor (ACharacter* Character, float InDeltaTime, FVector const& NewAccel, class FNetworkPredictionData_Client_Character& ClientData) override;
+	virtual void SetInitialPosition (ACharacter* Character) override;
+	virtual void PrepMoveFor (ACharacter* Character) override;
+
+	/** slide button was held during move */
+	uint32 bWantsToSlide : 1;
+
+	/** buffered slide press was consumed for move ; sent to server as held slide button */
+	uint32 bBufferedSlide : 1;
+
+	/** pawn was sliding when move started */
+	uint32 bStartInSlide : 1;
+
+	/** CurrentSlideVelocityReduction when move started */
+	float StartSlideVelocityReduction;
+
+	/** slide time not yet integrated when move started */
+	float StartSlideTimeAccumulator;
+};
+
+/** client prediction data allocating FSavedMove_Platformer */
+class FNetworkPredictionData_Client_Platformer : public FNetworkPredictionData_Client_Character {
+public:
+	typedef FNetworkPredictionData_Client_Character Super;
+
+	FNetworkPredictionData_Client_Platformer (const UCharacterMovementComponent& ClientMovement);
+
+	virtual FSavedMovePtr AllocateNewMove () override;
 };
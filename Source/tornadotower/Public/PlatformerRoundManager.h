@@ -0,0 +1,101 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "tornadotower.h"
+#include "GameFramework/Info.h"
+#include "PlatformerRoundManager.generated.h"
+
+/** steps of a round */
+UENUM()
+enum class EPlatformerRoundState : uint8 {
+	/** waiting for player to start */
+	Waiting,
+	/** round in progress */
+	Playing,
+	/** round over, waiting for restart */
+	Finished
+};
+
+/** state of an actor at round start */
+struct FPlatformerRoundActorState {
+	TWeakObjectPtr<AActor> Actor;
+	FVector Location;
+	FQuat Rotation;
+
+	/** pawn or physics body velocity */
+	FVector LinearVelocity;
+	FVector AngularVelocity;
+
+	/** control rotation of pawn's controller */
+	FRotator ControlRotation;
+
+	/** true for platformer characters, false for dynamic obstacles */
+	bool bCharacter;
+};
+
+/**
+* Round flow of time trial: start, finish and instant restart.
+* Round start stores transforms and velocities of platformer characters and movable obstacles,
+* restart puts them back in a single pass over that buffer ; nothing is respawned or reloaded.
+* Obstacles animated by their own logic (timelines, matinee) keep their own timing.
+* Spawned on demand, one per world, on server only.
+*/
+UCLASS(notplaceable)
+class TORNADOTOWER_API APlatformerRoundManager : public AInfo {
+	GENERATED_UCLASS_BODY()
+public:
+
+	/** returns round manager of given world, spawning it if needed ; NULL on clients */
+	static APlatformerRoundManager* Get (UWorld* World);
+
+	/** stores round start state and starts round */
+	UFUNCTION (BlueprintCallable, Category = Game)
+	void StartRound ();
+
+	/** ends round and lets characters play end of round animation */
+	UFUNCTION (BlueprintCallable, Category = Game)
+	void FinishRound (bool bWon);
+
+	/** restores round start state and starts round again ; returns false if no round was started yet */
+	UFUNCTION (BlueprintCallable, Category = Game)
+	bool TryRestartRound ();
+
+	EPlatformerRoundState GetRoundState () const {
+		return RoundState;
+	}
+
+	bool IsRoundInProgress () const {
+		return RoundState == EPlatformerRoundState::Playing;
+	}
+
+	bool IsRoundWon () const {
+		return bRoundWon;
+	}
+
+	/** returns time since round start, or duration of finished round */
+	UFUNCTION (BlueprintCallable, Category = Game)
+	float GetRoundTime () const;
+
+private:
+	/** current step of round */
+	EPlatformerRoundState RoundState;
+
+	/** world time of round start */
+	float RoundStartTime;
+
+	/** world time of round finish */
+	float RoundFinishTime;
+
+	/** state stored at round start */
+	TArray<FPlatformerRoundActorState> Snapshot;
+
+	/** true if finished round was won */
+	uint32 bRoundWon : 1;
+
+	/** fills Snapshot from current world */
+	void TakeSnapshot ();
+
+	/** applies Snapshot to world */
+	void RestoreSnapshot ();
+};
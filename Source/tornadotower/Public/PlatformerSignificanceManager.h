@@ -0,0 +1,96 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "tornadotower.h"
+#include "GameFramework/Info.h"
+#include "PlatformerSignificanceManager.generated.h"
+
+class APlatformerCharacter;
+
+/** how much work a character is allowed to spend on ticking and animation */
+UENUM()
+enum class EPlatformerSignificance : uint8 {
+	/** full rate tick, pose and bones updated every frame */
+	High,
+	/** lower anim tick rate, bones refreshed only when rendered */
+	Medium,
+	/** low actor and anim tick rate, pose ticked only when rendered */
+	Low
+};
+
+/**
+* Scores registered characters by distance to player views, visibility and gameplay relevance,
+* and throttles their actor tick, anim tick and bone updates accordingly.
+* Spawned on demand, one per world.
+*/
+UCLASS(config = Game, notplaceable)
+class TORNADOTOWER_API APlatformerSignificanceManager : public AInfo {
+	GENERATED_UCLASS_BODY()
+public:
+
+	/** returns manager of given world, spawning it if needed */
+	static APlatformerSignificanceManager* Get (UWorld* World);
+
+	/** re-scores characters every UpdateInterval */
+	virtual void Tick (float DeltaSeconds) override;
+
+	/** starts managing character */
+	void RegisterCharacter (APlatformerCharacter* Character);
+
+	/** stops managing character ; character is restored to high significance */
+	void UnregisterCharacter (APlatformerCharacter* Character);
+
+	/** tick interval of actor and anim for given significance */
+	float GetActorTickInterval (EPlatformerSignificance Significance) const;
+	float GetAnimTickInterval (EPlatformerSignificance Significance) const;
+
+private:
+	/** how often characters are re-scored */
+	UPROPERTY (EditDefaultsOnly, config, Category = Significance)
+		float UpdateInterval;
+
+	/** distance to closest player view at which distance score drops to zero */
+	UPROPERTY (EditDefaultsOnly, config, Category = Significance)
+		float MaxDistance;
+
+	/** time without being rendered after which character is considered not visible */
+	UPROPERTY (EditDefaultsOnly, config, Category = Significance)
+		float NotRenderedTime;
+
+	/** score multiplier for characters that aren't visible */
+	UPROPERTY (EditDefaultsOnly, config, Category = Significance)
+		float NotRenderedScoreScale;
+
+	/** minimal score for high significance */
+	UPROPERTY (EditDefaultsOnly, config, Category = Significance)
+		float HighScore;
+
+	/** minimal score for medium significance */
+	UPROPERTY (EditDefaultsOnly, config, Category = Significance)
+		float MediumScore;
+
+	/** anim tick interval for medium significance */
+	UPROPERTY (EditDefaultsOnly, config, Category = Significance)
+		float MediumAnimTickInterval;
+
+	/** actor tick interval for low significance */
+	UPROPERTY (EditDefaultsOnly, config, Category = Significance)
+		float LowActorTickInterval;
+
+	/** anim tick interval for low significance */
+	UPROPERTY (EditDefaultsOnly, config, Category = Significance)
+		float LowAnimTickInterval;
+
+	/** time left until next re-scoring */
+	float UpdateTimeLeft;
+
+	/** managed characters */
+	TArray<TWeakObjectPtr<APlatformerCharacter>> Characters;
+
+	/** player view locations, refreshed on every update */
+	TArray<FVector> ViewLocations;
+
+	/** returns score in [0, 1] ; anything gameplay relevant scores 1 */
+	float CalcScore (const APlatformerCharacter* Character) const;
+};
@@ -0,0 +1,79 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Core.h"
+
+/**
+* Structure-of-arrays view over a group of sliding pawns.
+* Buffers are owned by the caller and every array must hold at least Num elements.
+*/
+struct FPlatformerSlideBatch {
+	/** pawn velocity, updated in place */
+	float* VelocityX;
+	float* VelocityY;
+	float* VelocityZ;
+
+	/** impact normal of the floor each pawn is sliding on */
+	const float* FloorNormalX;
+	const float* FloorNormalY;
+	const float* FloorNormalZ;
+
+	/** accumulated slide velocity reduction (CurrentSlideVelocityReduction), updated in place */
+	float* Reduction;
+
+	/** value by which speed is reduced on flat ground or uphill (SlideVelocityReduction scaled by surface friction) */
+	const float* ReductionRate;
+
+	/** value by which speed is increased downhill (SlideVelocityReduction scaled by surface acceleration) */
+	const float* AccelerationRate;
+
+	/** minimal speed pawn can slide with */
+	const float* MinSpeed;
+
+	/** maximal speed pawn can slide with */
+	const float* MaxSpeed;
+
+	/** number of sliders in the batch */
+	int32 Num;
+
+	FPlatformerSlideBatch ()
+		: VelocityX (nullptr), VelocityY (nullptr), VelocityZ (nullptr)
+		, FloorNormalX (nullptr), FloorNormalY (nullptr), FloorNormalZ (nullptr)
+		, Reduction (nullptr), ReductionRate (nullptr), AccelerationRate (nullptr), MinSpeed (nullptr), MaxSpeed (nullptr)
+		, Num (0) {
+	}
+};
+
+/**
+* Slide integration shared by UPlatformerPlayerMovementComp and any system simulating many sliders.
+* Has no dependency on the world, so it can run on any thread.
+*/
+struct TORNADOTOWER_API FPlatformerSlideKernel {
+	/**
+	* advances a single slider by DeltaTime (already scaled by time dilation)
+	* accumulates InOutReduction based on floor slope, then applies it to InOutVelocity clamped to [MinSpeed, MaxSpeed]
+	* ReductionRate applies on flat ground or uphill, AccelerationRate downhill
+	*/
+	static FORCEINLINE void Step (FVector& InOutVelocity, const FVector& FloorNormal, float ReductionRate, float AccelerationRate, float MinSpeed, float MaxSpeed, float DeltaTime, float& InOutReduction) {
+		const FVector VelocityDir = InOutVelocity.GetSafeNormal ();
+
+		// sliding down a slope increases speed, sliding up or on flat ground reduces it
+		const float FloorDotVelocity = FVector::DotProduct (FloorNormal, VelocityDir);
+		const float SlopeCoef = 1.0f + FMath::Abs (FloorDotVelocity);
+		InOutReduction += (FloorDotVelocity > 0.0f ? AccelerationRate * SlopeCoef : -ReductionRate * SlopeCoef) * DeltaTime;
+
+		const FVector NewVelocity = InOutVelocity + InOutReduction * VelocityDir;
+		const float NewSpeedSq = NewVelocity.SizeSquared ();
+		if (NewSpeedSq > FMath::Square (MaxSpeed)) {
+			InOutVelocity = VelocityDir * MaxSpeed;
+		} else if (NewSpeedSq < FMath::Square (MinSpeed)) {
+			InOutVelocity = VelocityDir * MinSpeed;
+		} else {
+			InOutVelocity = NewVelocity;
+		}
+	}
+
+	/** advances every slider in Batch by DeltaTime, four at a time using vector registers */
+	static void StepBatch (const FPlatformerSlideBatch& Batch, float DeltaTime);
+};
@@ -0,0 +1,65 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "tornadotower.h"
+
+/**
+* Uniform 2D grid (XY plane) mapping cells to element indices.
+* Elements are inserted into every cell their bounds overlap, so a point query
+* only visits a single cell and its cost doesn't depend on total element count.
+*/
+class TORNADOTOWER_API FPlatformerSpatialHash {
+public:
+	explicit FPlatformerSpatialHash (float InCellSize = 200.0f);
+
+	/** changes cell size ; removes all elements */
+	void Init (float InCellSize);
+
+	/** removes all elements */
+	void Reset ();
+
+	/** inserts element into every cell overlapped by Bounds */
+	void Add (int32 Element, const FBox& Bounds);
+
+	/** removes element from every cell overlapped by Bounds ; Bounds must match the ones used in Add */
+	void Remove (int32 Element, const FBox& Bounds);
+
+	/** returns elements registered in cell containing Location, or nullptr if cell is empty */
+	const TArray<int32>* Find (const FVector& Location) const;
+
+	/** calls Visitor for every element in cells overlapped by Bounds ; elements spanning several cells may be visited more than once */
+	template <typename VisitorType>
+	void ForEachInBounds (const FBox& Bounds, VisitorType Visitor) const {
+		const FIntPoint MinCell = GetCell (Bounds.Min);
+		const FIntPoint MaxCell = GetCell (Bounds.Max);
+		for (int32 CellX = MinCell.X; CellX <= MaxCell.X; CellX++) {
+			for (int32 CellY = MinCell.Y; CellY <= MaxCell.Y; CellY++) {
+				if (const TArray<int32>* Elements = Cells.Find (FIntPoint (CellX, CellY))) {
+					for (int32 Element : *Elements) {
+						Visitor (Element);
+					}
+				}
+			}
+		}
+	}
+
+	/** returns cell containing Location */
+	FORCEINLINE FIntPoint GetCell (const FVector& Location) const {
+		return FIntPoint (FMath::FloorToInt (Location.X * InvCellSize), FMath::FloorToInt (Location.Y * InvCellSize));
+	}
+
+	float GetCellSize () const {
+		return CellSize;
+	}
+
+private:
+	/** size of a single cell */
+	float CellSize;
+
+	/** 1 / CellSize */
+	float InvCellSize;
+
+	/** elements registered in each non-empty cell */
+	TMap<FIntPoint, TArray<int32>> Cells;
+};
@@ -0,0 +1,64 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "tornadotower.h"
+
+class APlatformerCharacter;
+
+/**
+* Transient game world built from box collision only, used by commandlets to exercise
+* platformer movement without loading a map or any content.
+*
+* Layout (X is the running direction):
+* - floor spanning the whole course at Z = 0
+* - obstacle wall of ObstacleHeight at ObstacleX
+* - low ceiling, leaving room for a sliding pawn only, between CeilingStartX and CeilingEndX
+*/
+class TORNADOTOWER_API FPlatformerTestLevel {
+public:
+	/** X coordinate of the obstacle wall face */
+	static const float ObstacleX;
+
+	/** height of the obstacle wall */
+	static const float ObstacleHeight;
+
+	/** X range covered by the low ceiling */
+	static const float CeilingStartX;
+	static const float CeilingEndX;
+
+	/** bottom Z of the low ceiling */
+	static const float CeilingZ;
+
+	FPlatformerTestLevel ();
+	~FPlatformerTestLevel ();
+
+	/** creates world and geometry ; returns false if world couldn't be created */
+	bool Create ();
+
+	/** tears down world created by Create */
+	void Destroy ();
+
+	/** spawns a platformer pawn standing on the floor at given X/Y */
+	APlatformerCharacter* SpawnCharacter (UClass* CharacterClass, float X, float Y);
+
+	/** spawns static box blocking all channels */
+	AActor* SpawnBlock (const FVector& Center, const FVector& Extent);
+
+	/**
+	* fills area between StartX and EndX, MinY and MaxY with walls across the running direction:
+	* obstacles of random height to climb over and low ceilings to slide under, placed every Spacing
+	*/
+	void SpawnObstacleCourse (float StartX, float EndX, float MinY, float MaxY, float Spacing, int32 Seed);
+
+	/** advances world by DeltaSeconds */
+	void Tick (float DeltaSeconds);
+
+	UWorld* GetWorld () const {
+		return World;
+	}
+
+private:
+	/** world owned by this level */
+	UWorld* World;
+};
@@ -0,0 +1,40 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "tornadotower.h"
+#include "PlatformerTraceFormat.h"
+
+/** trace is compiled in every configuration, shipping included ; an event costs a ring buffer write */
+#ifndef PLATFORMER_TRACE_ENABLED
+	#define PLATFORMER_TRACE_ENABLED 1
+#endif
+
+/**
+* Binary event trace. Every thread writes fixed size events to its own ring buffer, without locks or formatting,
+* keeping the last EventsPerThread events of each thread. Buffers are written to file on demand by Dump
+* or Platformer.Trace.Dump console command, and read by Tools/PlatformerTraceDecoder.
+*/
+struct TORNADOTOWER_API FPlatformerTrace {
+	/** ring buffer size, power of two */
+	static const uint32 EventsPerThread = 4096;
+
+	/** false stops recording, events already recorded are kept ; Platformer.Trace console variable */
+	static bool bEnabled;
+
+	/** adds event to calling thread's buffer */
+	static void Record (EPlatformerTraceEvent::Type Type, uint32 ObjectId, float Value0 = 0.0f, float Value1 = 0.0f, uint8 Data = 0);
+
+	/** writes buffers of all threads to file ; events recorded while dumping may come out torn */
+	static bool Dump (const FString& Filename);
+
+	/** returns new file name in Saved/Traces */
+	static FString GetDefaultDumpFilename ();
+};
+
+/** records event of given EPlatformerTraceEvent type for Object, optionally with Value0, Value1 and Data */
+#if PLATFORMER_TRACE_ENABLED
+	#define PLATFORMER_TRACE(Type, Object, ...) FPlatformerTrace::Record (EPlatformerTraceEvent::Type, (Object)->GetUniqueID (), ##__VA_ARGS__)
+#else
+	#define PLATFORMER_TRACE(Type, Object, ...)
+#endif
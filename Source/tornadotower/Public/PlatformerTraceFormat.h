@@ -0,0 +1,88 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+// Shared by FPlatformerTrace and Tools/PlatformerTraceDecoder, so it must not depend on the engine.
+#include <stdint.h>
+
+/**
+* Trace file layout, little endian:
+*   FPlatformerTraceFileHeader
+*   for each thread: FPlatformerTraceThreadHeader, FPlatformerTraceEvent[NumEvents] oldest first
+*/
+namespace PlatformerTraceFormat {
+	/** 'PTRC' */
+	static const uint32_t FileMagic = 0x50545243;
+	static const uint16_t FileVersion = 1;
+}
+
+/** traced events ; meaning of event values depends on type */
+namespace EPlatformerTraceEvent {
+	enum Type : uint8_t {
+		/** Value0: speed */
+		SlideStart,
+		/** Value0: speed */
+		SlideEnd,
+		/** Value0: speed, Data: 1 if found by look-ahead sweep */
+		ObstacleHit,
+		/** Value0: obstacle height above feet, Data: EPlatformerObstacleClass */
+		Vault,
+		/** Value0: restored speed */
+		Resume,
+		JumpPressed,
+		JumpReleased,
+		SlidePressed,
+		SlideReleased,
+
+		Num
+	};
+}
+
+struct FPlatformerTraceFileHeader {
+	uint32_t Magic;
+	uint16_t Version;
+	/** sizeof (FPlatformerTraceEvent) */
+	uint16_t EventSize;
+	uint32_t NumThreads;
+	uint32_t Reserved;
+};
+
+struct FPlatformerTraceThreadHeader {
+	uint32_t ThreadId;
+	uint32_t NumEvents;
+	/** events overwritten before dump */
+	uint64_t NumLost;
+};
+
+struct FPlatformerTraceEvent {
+	/** seconds since process start */
+	double Time;
+	/** unique id of object event happened to */
+	uint32_t ObjectId;
+	/** EPlatformerTraceEvent */
+	uint8_t Type;
+	uint8_t Data;
+	uint16_t Reserved;
+	float Value0;
+	float Value1;
+};
+
+static_assert (sizeof (FPlatformerTraceFileHeader) == 16, "trace file header is written as is");
+static_assert (sizeof (FPlatformerTraceThreadHeader) == 16, "trace thread header is written as is");
+static_assert (sizeof (FPlatformerTraceEvent) == 24, "trace event is written as is");
+
+/** returns readable name of event type */
+inline const char* GetPlatformerTraceEventName (uint8_t Type) {
+	switch (Type) {
+		case EPlatformerTraceEvent::SlideStart:		return "SlideStart";
+		case EPlatformerTraceEvent::SlideEnd:		return "SlideEnd";
+		case EPlatformerTraceEvent::ObstacleHit:	return "ObstacleHit";
+		case EPlatformerTraceEvent::Vault:			return "Vault";
+		case EPlatformerTraceEvent::Resume:			return "Resume";
+		case EPlatformerTraceEvent::JumpPressed:	return "JumpPressed";
+		case EPlatformerTraceEvent::JumpReleased:	return "JumpReleased";
+		case EPlatformerTraceEvent::SlidePressed:	return "SlidePressed";
+		case EPlatformerTraceEvent::SlideReleased:	return "SlideReleased";
+		default:									return "Unknown";
+	}
+}
@@ -7,5 +7,7 @@ public class tornadotower : ModuleRules
 	public tornadotower(TargetInfo Target)
 	{
 		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "HeadMountedDisplay" });
+
+		PrivateDependencyModuleNames.AddRange(new string[] { "Json", "RenderCore" });
 	}
 }
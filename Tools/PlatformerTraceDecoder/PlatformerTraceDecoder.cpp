@@ -0,0 +1,123 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+/**
+* Prints trace files written by Platformer.Trace.Dump, events of all threads merged by time,
+* followed by number of events of each type.
+* Doesn't depend on the engine, build with:
+*   g++ -O2 -std=c++11 -o PlatformerTraceDecoder PlatformerTraceDecoder.cpp
+*   cl /O2 /EHsc PlatformerTraceDecoder.cpp
+* Usage: PlatformerTraceDecoder [--csv] <file.ptrace>
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+#include "../../Source/tornadotower/Public/PlatformerTraceFormat.h"
+
+struct FDecodedEvent {
+	uint32_t ThreadId;
+	FPlatformerTraceEvent Event;
+};
+
+static bool ReadTrace (FILE* File, std::vector<FDecodedEvent>& OutEvents, uint64_t& OutNumLost) {
+	FPlatformerTraceFileHeader Header;
+	if (fread (&Header, sizeof (Header), 1, File) != 1 || Header.Magic != PlatformerTraceFormat::FileMagic) {
+		fprintf (stderr, "not a platformer trace file\n");
+		return false;
+	}
+
+	if (Header.Version != PlatformerTraceFormat::FileVersion || Header.EventSize != sizeof (FPlatformerTraceEvent)) {
+		fprintf (stderr, "unsupported trace version %u, event size %u\n", Header.Version, Header.EventSize);
+		return false;
+	}
+
+	OutNumLost = 0;
+	for (uint32_t ThreadIdx = 0; ThreadIdx < Header.NumThreads; ThreadIdx++) {
+		FPlatformerTraceThreadHeader ThreadHeader;
+		if (fread (&ThreadHeader, sizeof (ThreadHeader), 1, File) != 1) {
+			fprintf (stderr, "trace file is truncated\n");
+			return false;
+		}
+
+		OutNumLost += ThreadHeader.NumLost;
+		const size_t First = OutEvents.size ();
+		OutEvents.resize (First + ThreadHeader.NumEvents);
+		for (uint32_t EventIdx = 0; EventIdx < ThreadHeader.NumEvents; EventIdx++) {
+			FDecodedEvent& Decoded = OutEvents[First + EventIdx];
+			Decoded.ThreadId = ThreadHeader.ThreadId;
+			if (fread (&Decoded.Event, sizeof (Decoded.Event), 1, File) != 1) {
+				fprintf (stderr, "trace file is truncated\n");
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+int main (int argc, char** argv) {
+	bool bCsv = false;
+	const char* Filename = NULL;
+	for (int ArgIdx = 1; ArgIdx < argc; ArgIdx++) {
+		if (strcmp (argv[ArgIdx], "--csv") == 0) {
+			bCsv = true;
+		} else {
+			Filename = argv[ArgIdx];
+		}
+	}
+
+	if (!Filename) {
+		fprintf (stderr, "usage: %s [--csv] <file.ptrace>\n", argv[0]);
+		return 1;
+	}
+
+	FILE* File = fopen (Filename, "rb");
+	if (!File) {
+		fprintf (stderr, "failed to open %s\n", Filename);
+		return 1;
+	}
+
+	std::vector<FDecodedEvent> Events;
+	uint64_t NumLost = 0;
+	const bool bRead = ReadTrace (File, Events, NumLost);
+	fclose (File);
+	if (!bRead) {
+		return 1;
+	}
+
+	// threads are stored one after another, each oldest first
+	std::stable_sort (Events.begin (), Events.end (), [] (const FDecodedEvent& A, const FDecodedEvent& B) {
+		return A.Event.Time < B.Event.Time;
+	});
+
+	uint64_t TypeCounts[EPlatformerTraceEvent::Num + 1] = { 0 };
+	if (bCsv) {
+		printf ("Time,Thread,Object,Event,Data,Value0,Value1\n");
+	}
+
+	for (const FDecodedEvent& Decoded : Events) {
+		const FPlatformerTraceEvent& Event = Decoded.Event;
+		TypeCounts[std::min<uint32_t> (Event.Type, EPlatformerTraceEvent::Num)]++;
+
+		if (bCsv) {
+			printf ("%.6f,%u,%u,%s,%u,%f,%f\n", Event.Time, Decoded.ThreadId, Event.ObjectId,
+				GetPlatformerTraceEventName (Event.Type), Event.Data, Event.Value0, Event.Value1);
+		} else {
+			printf ("%12.6f  thread %-6u object %-8u %-14s data %-3u %10.2f %10.2f\n", Event.Time, Decoded.ThreadId, Event.ObjectId,
+				GetPlatformerTraceEventName (Event.Type), Event.Data, Event.Value0, Event.Value1);
+		}
+	}
+
+	// summary goes to stderr, so csv output stays clean
+	FILE* Summary = bCsv ? stderr : stdout;
+	fprintf (Summary, "\n%u events, %llu lost to ring buffer wrap\n", (uint32_t)Events.size (), (unsigned long long)NumLost);
+	for (uint32_t Type = 0; Type <= EPlatformerTraceEvent::Num; Type++) {
+		if (TypeCounts[Type] > 0) {
+			fprintf (Summary, "  %-14s %llu\n", GetPlatformerTraceEventName ((uint8_t)Type), (unsigned long long)TypeCounts[Type]);
+		}
+	}
+
+	return 0;
+}